@@ -0,0 +1,129 @@
+#include "aggregates.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include "string_pool.h"
+
+namespace s21 {
+
+double Aggregates::Summary::Average() const {
+  return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+}
+
+bool Aggregates::ParseGrouping(const std::string& name, Grouping* grouping) {
+  if (name == "city") {
+    *grouping = kByCity;
+  } else if (name == "year") {
+    *grouping = kByYear;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void Aggregates::AddGrouping(Grouping grouping, const Storage& storage) {
+  if (is_grouped_[grouping]) return;
+  is_grouped_[grouping] = true;
+  storage.ForEach([this, grouping](const Storage::Element& element) {
+    const Record& record = element.GetRecord();
+    if (grouping == kByCity) {
+      Add(&cities_[record.city], record.coins);
+    } else {
+      Add(&years_[record.year_of_birth], record.coins);
+    }
+  });
+}
+
+void Aggregates::DropGrouping(Grouping grouping) {
+  is_grouped_[grouping] = false;
+  if (grouping == kByCity) {
+    cities_.clear();
+  } else {
+    years_.clear();
+  }
+}
+
+bool Aggregates::IsGrouped(Grouping grouping) const {
+  return is_grouped_[grouping];
+}
+
+bool Aggregates::HasGroupings() const {
+  return is_grouped_[kByCity] || is_grouped_[kByYear];
+}
+
+void Aggregates::Insert(const Record& record) {
+  if (is_grouped_[kByCity]) Add(&cities_[record.city], record.coins);
+  if (is_grouped_[kByYear]) Add(&years_[record.year_of_birth], record.coins);
+}
+
+void Aggregates::Erase(const Record& record) {
+  if (is_grouped_[kByCity]) {
+    auto it = cities_.find(record.city);
+    if (it != cities_.end() && Remove(&it->second, record.coins)) cities_.erase(it);
+  }
+  if (is_grouped_[kByYear]) {
+    auto it = years_.find(record.year_of_birth);
+    if (it != years_.end() && Remove(&it->second, record.coins)) years_.erase(it);
+  }
+}
+
+void Aggregates::Clear() {
+  cities_.clear();
+  years_.clear();
+}
+
+void Aggregates::Rebuild(const Storage& storage) {
+  Clear();
+  storage.ForEach([this](const Storage::Element& element) { Insert(element.GetRecord()); });
+}
+
+std::vector<Aggregates::Row> Aggregates::Rows(Grouping grouping) const {
+  std::vector<Row> rows;
+  if (grouping == kByCity) {
+    for (const auto& city : cities_) rows.push_back({StringPool::Get(city.first), city.second.GetSummary()});
+    std::sort(rows.begin(), rows.end(), [](const Row& left, const Row& right) { return left.group < right.group; });
+  } else {
+    for (const auto& year : years_) rows.push_back({std::to_string(year.first), year.second.GetSummary()});
+  }
+  return rows;
+}
+
+bool Aggregates::Find(Grouping grouping, const std::string& group, Summary* summary) const {
+  if (grouping == kByCity) {
+    auto it = cities_.find(StringPool::Find(group));
+    if (it == cities_.end()) return false;
+    *summary = it->second.GetSummary();
+    return true;
+  }
+  /* digits only and few enough for a 32-bit year */
+  const size_t kMaxDigits = std::numeric_limits<int32_t>::digits10;
+  if (group.empty() || group.length() > kMaxDigits ||
+      !std::all_of(group.begin(), group.end(), [](unsigned char c) { return std::isdigit(c); })) {
+    return false;
+  }
+  auto it = years_.find(std::stoi(group));
+  if (it == years_.end()) return false;
+  *summary = it->second.GetSummary();
+  return true;
+}
+
+Aggregates::Summary Aggregates::Group::GetSummary() const {
+  return {count, sum, coins.begin()->first, coins.rbegin()->first};
+}
+
+void Aggregates::Add(Group* group, int32_t coins) {
+  ++group->count;
+  group->sum += coins;
+  ++group->coins[coins];
+}
+
+bool Aggregates::Remove(Group* group, int32_t coins) {
+  auto it = group->coins.find(coins);
+  if (it == group->coins.end()) return false;
+  --group->count;
+  group->sum -= coins;
+  if (--it->second == 0) group->coins.erase(it);
+  return group->count == 0;
+}
+
+}  // namespace s21
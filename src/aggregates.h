@@ -0,0 +1,85 @@
+#ifndef SRC_AGGREGATES_H_
+#define SRC_AGGREGATES_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "storage.h"
+
+namespace s21 {
+
+/* Count, sum, min, max and average of coins grouped by city or by year of
+   birth, kept up to date with the records instead of computed by a scan.
+   A group is built from the storage the first time it is asked for. Count
+   and sum change in O(1); min and max survive removals because every group
+   counts its records per coins value, which costs O(log v) for v distinct
+   values. The owner keeps the groups in step with the storage and
+   synchronizes the calls. */
+class Aggregates {
+ public:
+  using Record = Storage::Element::Record;
+
+  enum Grouping {
+    kByCity,
+    kByYear,
+    kGroupingsCount
+  };
+
+  struct Summary {
+    size_t count = 0;
+    int64_t sum = 0;
+    int32_t min = 0;
+    int32_t max = 0;
+
+    double Average() const;
+  };
+
+  struct Row {
+    std::string group;
+    Summary summary;
+  };
+
+  /* city or year */
+  static bool ParseGrouping(const std::string& name, Grouping* grouping);
+
+  void AddGrouping(Grouping grouping, const Storage& storage);
+  /* forgets the groups, they are built again when asked for */
+  void DropGrouping(Grouping grouping);
+  bool IsGrouped(Grouping grouping) const;
+  bool HasGroupings() const;
+
+  void Insert(const Record& record);
+  void Erase(const Record& record);
+  /* forgets the records, the groupings stay */
+  void Clear();
+  void Rebuild(const Storage& storage);
+
+  /* cities by name, years in order */
+  std::vector<Row> Rows(Grouping grouping) const;
+  /* false when no record is in the group */
+  bool Find(Grouping grouping, const std::string& group, Summary* summary) const;
+
+ private:
+  struct Group {
+    size_t count = 0;
+    int64_t sum = 0;
+    /* records per coins value */
+    std::map<int32_t, size_t> coins;
+
+    Summary GetSummary() const;
+  };
+
+  bool is_grouped_[kGroupingsCount] = {};
+  std::unordered_map<uint32_t, Group> cities_;
+  std::map<int32_t, Group> years_;
+
+  static void Add(Group* group, int32_t coins);
+  /* true when the group is left empty */
+  static bool Remove(Group* group, int32_t coins);
+};
+
+}  // namespace s21
+
+#endif  // SRC_AGGREGATES_H_
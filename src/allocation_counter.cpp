@@ -0,0 +1,82 @@
+#include "allocation_counter.h"
+#ifdef COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace {
+std::atomic<size_t> allocations{0};
+std::atomic<size_t> bytes{0};
+
+size_t UsableSize(void* pointer) {
+#ifdef __APPLE__
+  return malloc_size(pointer);
+#else
+  return malloc_usable_size(pointer);
+#endif
+}
+
+void Free(void* pointer) {
+  if (!pointer) return;
+  bytes.fetch_sub(UsableSize(pointer), std::memory_order_relaxed);
+  std::free(pointer);
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  void* pointer = std::malloc(size);
+  if (!pointer) throw std::bad_alloc();
+  bytes.fetch_add(UsableSize(pointer), std::memory_order_relaxed);
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  Free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  Free(pointer);
+}
+
+namespace s21 {
+
+bool AllocationCounter::IsCounting() {
+  return true;
+}
+
+size_t AllocationCounter::Count() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+size_t AllocationCounter::Bytes() {
+  return bytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace s21
+
+#else
+
+namespace s21 {
+
+bool AllocationCounter::IsCounting() {
+  return false;
+}
+
+size_t AllocationCounter::Count() {
+  return 0;
+}
+
+size_t AllocationCounter::Bytes() {
+  return 0;
+}
+
+}  // namespace s21
+
+#endif  // COUNT_ALLOCATIONS
@@ -0,0 +1,25 @@
+#ifndef SRC_ALLOCATION_COUNTER_H_
+#define SRC_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace s21 {
+
+/* counts calls of the global operator new made by any thread since start,
+   the difference of two readings is the number of heap allocations made
+   in between. The counting operator new costs every allocation two shared
+   atomics, so it is built only with COUNT_ALLOCATIONS: by the tests and by
+   make compare, not into the program itself. */
+class AllocationCounter {
+ public:
+  /* false when built without COUNT_ALLOCATIONS, the readings are then 0 */
+  static bool IsCounting();
+  static size_t Count();
+  /* heap bytes taken through operator new and not yet freed, as reported
+     by the allocator, so with its rounding */
+  static size_t Bytes();
+};
+
+}  // namespace s21
+
+#endif  // SRC_ALLOCATION_COUNTER_H_
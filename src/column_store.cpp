@@ -0,0 +1,120 @@
+#include "column_store.h"
+#include <algorithm>
+#include "string_pool.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace s21 {
+
+void ColumnStore::Insert(const std::string& key, const Record& record) {
+  auto it = rows_.emplace(key, keys_.size()).first;
+  keys_.push_back(&it->first);
+  surnames_.push_back(record.surname);
+  names_.push_back(record.name);
+  years_.push_back(record.year_of_birth);
+  cities_.push_back(record.city);
+  coins_.push_back(record.coins);
+}
+
+void ColumnStore::Erase(const std::string& key) {
+  auto it = rows_.find(key);
+  if (it == rows_.end()) return;
+  const uint32_t row = it->second;
+  const uint32_t last = keys_.size() - 1;
+  if (row != last) {
+    keys_[row] = keys_[last];
+    surnames_[row] = surnames_[last];
+    names_[row] = names_[last];
+    years_[row] = years_[last];
+    cities_[row] = cities_[last];
+    coins_[row] = coins_[last];
+    rows_.find(*keys_[row])->second = row;
+  }
+  rows_.erase(it);
+  keys_.pop_back();
+  surnames_.pop_back();
+  names_.pop_back();
+  years_.pop_back();
+  cities_.pop_back();
+  coins_.pop_back();
+}
+
+void ColumnStore::Clear() {
+  ColumnStore().Swap(this);
+}
+
+void ColumnStore::Rebuild(const Storage& storage) {
+  Clear();
+  storage.ForEach([this](const Storage::Element& element) {
+    Insert(element.GetKey(), element.GetRecord());
+  });
+}
+
+size_t ColumnStore::Size() const {
+  return keys_.size();
+}
+
+/* a column without a condition is not read at all, a block whose mask is
+   already empty skips the rest of the columns */
+std::vector<std::string> ColumnStore::Find(const Query& query) const {
+  std::vector<std::string> result;
+  if (query.year_of_birth.min > query.year_of_birth.max || query.coins.min > query.coins.max) return result;
+  const size_t size = keys_.size();
+  for (size_t begin = 0; begin < size; begin += kBlockRows) {
+    const size_t count = std::min(kBlockRows, size - begin);
+    uint64_t mask = count == kBlockRows ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    if (mask && query.surname != StringPool::kEmptyCode) mask &= Equal(&surnames_[begin], count, query.surname);
+    if (mask && query.name != StringPool::kEmptyCode) mask &= Equal(&names_[begin], count, query.name);
+    if (mask && query.city != StringPool::kEmptyCode) mask &= Equal(&cities_[begin], count, query.city);
+    if (mask && !query.year_of_birth.IsAll()) mask &= InRange(&years_[begin], count, query.year_of_birth);
+    if (mask && !query.coins.IsAll()) mask &= InRange(&coins_[begin], count, query.coins);
+    for (; mask; mask &= mask - 1) result.push_back(*keys_[begin + __builtin_ctzll(mask)]);
+  }
+  return result;
+}
+
+void ColumnStore::Swap(ColumnStore* other) {
+  rows_.swap(other->rows_);
+  keys_.swap(other->keys_);
+  surnames_.swap(other->surnames_);
+  names_.swap(other->names_);
+  years_.swap(other->years_);
+  cities_.swap(other->cities_);
+  coins_.swap(other->coins_);
+}
+
+/* SSE2 compares four rows at a time, the tail of a block goes one by one */
+uint64_t ColumnStore::Equal(const uint32_t* column, size_t count, uint32_t code) {
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i value = _mm_set1_epi32(static_cast<int>(code));
+  for (; i + 4 <= count; i += 4) {
+    const __m128i rows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    const int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(rows, value)));
+    mask |= static_cast<uint64_t>(bits) << i;
+  }
+#endif
+  for (; i < count; ++i) mask |= static_cast<uint64_t>(column[i] == code) << i;
+  return mask;
+}
+
+uint64_t ColumnStore::InRange(const int32_t* column, size_t count, const Storage::Element::Range& range) {
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i min = _mm_set1_epi32(range.min);
+  const __m128i max = _mm_set1_epi32(range.max);
+  for (; i + 4 <= count; i += 4) {
+    const __m128i rows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    const __m128i outside = _mm_or_si128(_mm_cmplt_epi32(rows, min), _mm_cmpgt_epi32(rows, max));
+    const int bits = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+    mask |= static_cast<uint64_t>(bits) << i;
+  }
+#endif
+  for (; i < count; ++i) mask |= static_cast<uint64_t>(range.Contains(column[i])) << i;
+  return mask;
+}
+
+}  // namespace s21
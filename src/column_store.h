@@ -0,0 +1,52 @@
+#ifndef SRC_COLUMN_STORE_H_
+#define SRC_COLUMN_STORE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "storage.h"
+
+namespace s21 {
+
+/* A shadow of the records kept by columns: one contiguous array per field,
+   text fields as their StringPool codes. FIND without an index compares
+   whole blocks of a column at once instead of visiting the elements one by
+   one. Rows stay dense: an erased row is filled with the last one. The
+   owner keeps the columns in step with the storage and synchronizes the
+   calls. */
+class ColumnStore {
+ public:
+  using Record = Storage::Element::Record;
+  using Query = Storage::Element::Query;
+
+  void Insert(const std::string& key, const Record& record);
+  void Erase(const std::string& key);
+  /* gives the memory back */
+  void Clear();
+  void Rebuild(const Storage& storage);
+  size_t Size() const;
+  std::vector<std::string> Find(const Query& query) const;
+
+ private:
+  /* one bit of a mask per row */
+  static constexpr size_t kBlockRows = 64;
+
+  /* keys_ points to the keys of rows_, nodes of the map do not move */
+  std::unordered_map<std::string, uint32_t> rows_;
+  std::vector<const std::string*> keys_;
+  std::vector<uint32_t> surnames_;
+  std::vector<uint32_t> names_;
+  std::vector<int32_t> years_;
+  std::vector<uint32_t> cities_;
+  std::vector<int32_t> coins_;
+
+  void Swap(ColumnStore* other);
+  /* bit i is set when row i of the block matches */
+  static uint64_t Equal(const uint32_t* column, size_t count, uint32_t code);
+  static uint64_t InRange(const int32_t* column, size_t count, const Storage::Element::Range& range);
+};
+
+}  // namespace s21
+
+#endif  // SRC_COLUMN_STORE_H_
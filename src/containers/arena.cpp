@@ -0,0 +1,65 @@
+#include "arena.h"
+#include <algorithm>
+#include <new>
+
+namespace s21 {
+
+Arena::~Arena() {
+  Release();
+}
+
+void* Arena::Allocate(size_t size) {
+  if (size > kMaxPieceSize) {
+    blocks_.push_back(nullptr);
+    blocks_.back() = ::operator new(size);
+    return blocks_.back();
+  }
+  const size_t size_class = SizeClass(size);
+  if (FreePiece* piece = free_lists_[size_class]) {
+    free_lists_[size_class] = piece->next;
+    return piece;
+  }
+  const size_t piece_size = (size_class + 1) * kAlignment;
+  if (free_size_ < piece_size) {
+    blocks_.push_back(nullptr);
+    blocks_.back() = ::operator new(kBlockSize);
+    free_space_ = static_cast<char*>(blocks_.back());
+    free_size_ = kBlockSize;
+  }
+  void* piece = free_space_;
+  free_space_ += piece_size;
+  free_size_ -= piece_size;
+  return piece;
+}
+
+void Arena::Deallocate(void* piece, size_t size) {
+  if (!piece || size > kMaxPieceSize) return;
+  const size_t size_class = SizeClass(size);
+  free_lists_[size_class] = new (piece) FreePiece{free_lists_[size_class]};
+}
+
+void Arena::Release() {
+  for (void* block : blocks_) ::operator delete(block);
+  blocks_.clear();
+  free_space_ = nullptr;
+  free_size_ = 0;
+  std::fill(std::begin(free_lists_), std::end(free_lists_), nullptr);
+}
+
+void Arena::Swap(Arena* other) {
+  std::swap(blocks_, other->blocks_);
+  std::swap(free_space_, other->free_space_);
+  std::swap(free_size_, other->free_size_);
+  std::swap(free_lists_, other->free_lists_);
+}
+
+size_t Arena::Blocks() const {
+  return blocks_.size();
+}
+
+/* 0 for 1..16 bytes, 1 for 17..32 and so on */
+size_t Arena::SizeClass(size_t size) {
+  return (std::max<size_t>(size, 1) - 1) / kAlignment;
+}
+
+}  // namespace s21
@@ -0,0 +1,61 @@
+#ifndef SRC_CONTAINERS_ARENA_H_
+#define SRC_CONTAINERS_ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace s21 {
+
+/* Memory of one storage. Small pieces are cut from big blocks one after
+   another, so nodes created together lie together; a freed piece goes to the
+   free list of its size class and is given out again first. Pieces bigger
+   than kMaxPieceSize get a block of their own and stay until Release.
+   Release gives every block back at once without looking at the pieces:
+   objects living there are not destroyed. Not thread safe. */
+class Arena {
+ public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  void* Allocate(size_t size);
+  void Deallocate(void* piece, size_t size);
+  void Release();
+  void Swap(Arena* other);
+  size_t Blocks() const;
+
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  void Delete(T* object) {
+    object->~T();
+    Deallocate(object, sizeof(T));
+  }
+
+ private:
+  struct FreePiece {
+    FreePiece* next;
+  };
+
+  static constexpr size_t kBlockSize = 64 * 1024;
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+  static constexpr size_t kMaxPieceSize = 256;
+  static constexpr size_t kSizeClasses = kMaxPieceSize / kAlignment;
+
+  std::vector<void*> blocks_;
+  char* free_space_ = nullptr;
+  size_t free_size_ = 0;
+  FreePiece* free_lists_[kSizeClasses] = {};
+
+  static size_t SizeClass(size_t size);
+};
+
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_ARENA_H_
@@ -1,605 +1,534 @@
 #include "b_plus_tree.h"
-#include <fstream>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
 
 namespace s21 {
 
-using data_t = Storage::Element::Data;
+namespace {
 
-/* -------------------------------------------------------------------------- */
-/*                                  override                                  */
-/* -------------------------------------------------------------------------- */
+constexpr size_t kHeadBytes = sizeof(uint64_t);
 
-void BPlusTree::Set(element element) {
-  string key_of_this_element = element.GetKey();
-  Node* node_for_key = GetReferenceOfNodeForThisKeyFromNode(key_of_this_element, root_);
-  if (node_for_key->HasKey(key_of_this_element) == false) {
-    if (node_for_key->GetKeyelements().size() == 2 * kOrder - 1) {
-        DivideOnTwoNods(node_for_key);
-        node_for_key = GetReferenceOfNodeForThisKeyFromNode(key_of_this_element, root_);
-        node_for_key->InsertElementInNode(element, nullptr, nullptr);
+/* the first bytes of a key as a big-endian number padded with zeros: a
+   smaller head means a smaller key, equal heads say nothing */
+uint64_t Head(const std::string& key) {
+  uint64_t head = 0;
+  for (size_t i = 0; i < kHeadBytes; ++i) {
+    head = (head << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+  }
+  return head;
+}
+
+/* the first entry whose key is not less than key, greater with is_upper.
+   The heads narrow the search down to the entries with the head of key,
+   whole keys are read only among them. */
+template <typename KeyAt>
+size_t Bound(const std::vector<uint64_t>& heads, const std::string& key, const KeyAt& key_at, bool is_upper) {
+  const uint64_t head = Head(key);
+  size_t low = std::lower_bound(heads.begin(), heads.end(), head) - heads.begin();
+  size_t high = std::upper_bound(heads.begin() + low, heads.end(), head) - heads.begin();
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const std::string& current = key_at(middle);
+    if (is_upper ? current <= key : current < key) {
+      low = middle + 1;
     } else {
-      node_for_key->InsertElementInNode(element, nullptr, nullptr);
+      high = middle;
     }
   }
+  return low;
 }
 
-BPlusTree::Element BPlusTree::Get(string key) const {
-  Element result_element = Element();
-  Node* node_for_key = GetReferenceOfNodeForThisKeyFromNode(key, root_);
-  int number_of_key = node_for_key->NumberOfKeyThatClosest(key);
-  if (node_for_key->HasKey(key))
-    result_element = node_for_key->GetKeyelements()[number_of_key];
-  return result_element;
-}
+}  // namespace
 
-bool BPlusTree::Exists(string key) const {
-  Element element = Get(key);
-  if (element.GetKey() == "") return false;
-  return true;
+/* -------------------------------------------------------------------------- */
+/*                                  override                                  */
+/* -------------------------------------------------------------------------- */
+
+template <size_t Order>
+void BasicBPlusTree<Order>::Set(element element) {
+  Set(Element(element));
 }
 
-bool BPlusTree::Del(string key) {
-  Node* node_with_key = GetReferenceOfNodeForThisKeyFromNode(key, root_);
-  int number_of_key = node_with_key->NumberOfKeyThatClosest(key);
-  if (node_with_key->HasKey(key)) {
-    if (node_with_key->GetType() == Node::kList) {
-      node_with_key->DeleteKeyFromList(key, root_);
-    } else if (node_with_key->GetType() == Node::kRoot && node_with_key->GetChildren().size() == 0) {
-      node_with_key->DeleteElement(key);
-    } else {
-      node_with_key->DeleteKeyFromNotList(number_of_key, root_);
-    }
-  return true;
-  }
-  return false;
+/* a split of the root adds a level on top */
+template <size_t Order>
+void BasicBPlusTree<Order>::Set(Element&& element) {
+  std::string separator;
+  Node* right = Insert(root_, std::move(element), &separator);
+  if (!right) return;
+  Node* root = new Node(false);
+  root->heads.push_back(Head(separator));
+  root->keys.push_back(std::move(separator));
+  root->children = {root_, right};
+  root_ = root;
 }
 
-bool BPlusTree::Update(string key, const data_t& data) {
-  Node* node_for_key = GetReferenceOfNodeForThisKeyFromNode(key, root_);
-  int number_of_key = node_for_key->NumberOfKeyThatClosest(key);
-  if (node_for_key->HasKey(key)) {
-    node_for_key->UpdateData(number_of_key, data);
-    return true;
-  }
-  return false;
-}
-
-void BPlusTree::Node::UpdateData(int number, const data_t& data) {
-    Element element_for_change = keyelements_[number];
-    data_t data_for_change = element_for_change.GetData();
-    if (data.surname != "-") data_for_change.surname = data.surname;
-    if (data.name != "-") data_for_change.name = data.name;
-    if (data.year_of_birth != "-") data_for_change.year_of_birth = data.year_of_birth;
-    if (data.city != "-") data_for_change.city = data.city;
-    if (data.coins != "-") data_for_change.coins = data.coins;
-    element_for_change.SetData(data_for_change);
-    keyelements_[number] = element_for_change;
-}
-
-bool BPlusTree::Rename(string key, string new_key) {
-  Node* node_with_key = GetReferenceOfNodeForThisKeyFromNode(key, root_);
-  int number_of_element = node_with_key->NumberOfKeyThatClosest(key);
-  if (node_with_key->HasKey(key)) {
-    Element element_for_rename = node_with_key->GetKeyelements()[number_of_element];
-    Del(key);
-    element_for_rename.SetKey(new_key);
-    Set(element_for_rename);
-    return true;
-  }
-  return false;
+template <size_t Order>
+Storage::Element BasicBPlusTree<Order>::Get(string key) const {
+  const Element* element = FindElement(key);
+  if (element) return *element;
+  return Element();
 }
 
-int BPlusTree::Ttl(string key) const {
-  Element element_for_research = Get(key);
-  int life_time = 0;
-  if (element_for_research.GetKey() != "") life_time = element_for_research.GetLifeTime();
-  return life_time;
+template <size_t Order>
+bool BasicBPlusTree<Order>::Visit(string key, const Visitor& visitor) const {
+  const Element* element = FindElement(key);
+  if (!element) return false;
+  visitor(*element);
+  return true;
 }
 
-BPlusTree::vector BPlusTree::Find(const data_t& data) const {
-  std::vector<Element> vector_of_elements;
-  root_->TakeAllKeyelements(&vector_of_elements, data);
-  vector result;
-  std::transform(vector_of_elements.begin(), vector_of_elements.end(), std::back_inserter(result),
-                                            [](const Element& elem) {return elem.GetKey();});
-  return result;
+template <size_t Order>
+bool BasicBPlusTree<Order>::Exists(string key) const {
+  return FindElement(key) != nullptr;
 }
 
-void BPlusTree::Init() {
-  if (root_ != nullptr) {
-    root_->DeleteNodesInTreeWithThisRoot();
-    delete root_;
+/* a root left with a single child gives its place to it */
+template <size_t Order>
+bool BasicBPlusTree<Order>::Del(string key) {
+  bool is_erased = false;
+  Erase(root_, key, &is_erased);
+  if (!root_->is_leaf && root_->children.size() == 1) {
+    Node* root = root_;
+    root_ = root->children[0];
+    delete root;
   }
-  root_ = new Node(BPlusTree::Node::kRoot);
+  return is_erased;
 }
 
-std::vector<BPlusTree::Element> BPlusTree::AllElements() const {
-  std::vector<Element> result;
-  root_->TakeAllKeyelements(&result, {"", "", "", "", "", Node::kNullData});
-  return result;
+template <size_t Order>
+bool BasicBPlusTree<Order>::Update(string key, const data_t& data) {
+  Element* element = FindElement(key);
+  if (!element) return false;
+  element->UpdateData(data);
+  return true;
 }
-/* -------------------------------------------------------------------------- */
-/*                                 BPlusTree                                  */
-/* -------------------------------------------------------------------------- */
 
-BPlusTree::BPlusTree() {
-  root_ = new Node(Node::kRoot);
+/* a key that stays between the same neighbours of its leaf is changed where
+   it is, otherwise the record moves to the place of the new key */
+template <size_t Order>
+bool BasicBPlusTree<Order>::Rename(string key, string new_key) {
+  Node* leaf = FindLeaf(key);
+  const size_t number = LowerBound(leaf, key);
+  if (number == leaf->elements.size() || leaf->elements[number].GetKey() != key) return false;
+  if (key == new_key) return true;
+  if (FindElement(new_key)) return false;
+  const size_t new_number = LowerBound(leaf, new_key);
+  if (FindLeaf(new_key) == leaf && (new_number == number || new_number == number + 1)) {
+    leaf->elements[number].SetKey(new_key);
+    leaf->heads[number] = Head(new_key);
+    return true;
+  }
+  Element renamed(new_key, {});
+  *renamed = leaf->elements[number].GetRecord();
+  Del(key);
+  Set(std::move(renamed));
+  return true;
 }
 
-BPlusTree::BPlusTree(const BPlusTree& other) {
-  CopyTree(other);
+template <size_t Order>
+int BasicBPlusTree<Order>::Ttl(string key) const {
+  const Element* element = FindElement(key);
+  int life_time = 0;
+  if (element) life_time = element->GetLifeTime();
+  return life_time;
 }
 
-BPlusTree::BPlusTree(BPlusTree&& other) {
-  std::swap(root_, other.root_);
+template <size_t Order>
+void BasicBPlusTree<Order>::ForEach(const Visitor& visitor) const {
+  ForEachInLeaves(FirstLeaf(root_), nullptr, visitor);
 }
 
-BPlusTree& BPlusTree::operator=(const BPlusTree& other) {
-  CopyTree(other);
-  return *this;
+template <size_t Order>
+void BasicBPlusTree<Order>::ForEachBackward(const Visitor& visitor) const {
+  for (const Node* leaf = LastLeaf(root_); leaf; leaf = leaf->previous) {
+    for (auto element = leaf->elements.rbegin(); element != leaf->elements.rend(); ++element) visitor(*element);
+  }
 }
 
-BPlusTree& BPlusTree::operator=(const BPlusTree&& other) {
-  CopyTree(other);
-  return *this;
+/* A subtree gives way to its children level by level. Every leaf is as
+   deep as the others, the nodes of the leftmost path tell how big a
+   subtree of each level is. A part walks the leaves of its subtree, up to
+   the first leaf of the next one. */
+template <size_t Order>
+std::vector<Storage::Part> BasicBPlusTree<Order>::Split(size_t parts) const {
+  std::vector<const Node*> path;
+  for (const Node* node = root_; node; node = node->is_leaf ? nullptr : node->children[0]) {
+    path.push_back(node);
+  }
+  std::vector<size_t> sizes(path.size());
+  for (size_t level = path.size(); level-- > 0;) {
+    sizes[level] = path[level]->is_leaf ? path[level]->elements.size()
+                                        : path[level]->children.size() * sizes[level + 1];
+  }
+  std::vector<const Node*> pieces = {root_};
+  for (size_t level = 0; pieces.size() < parts && level + 1 < path.size() && sizes[level + 1] >= kMinPartSize;
+       ++level) {
+    std::vector<const Node*> next;
+    for (const Node* piece : pieces) next.insert(next.end(), piece->children.begin(), piece->children.end());
+    pieces.swap(next);
+  }
+  std::vector<Part> result;
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    const Node* first = FirstLeaf(pieces[i]);
+    const Node* end = i + 1 < pieces.size() ? FirstLeaf(pieces[i + 1]) : nullptr;
+    result.push_back([first, end](const Visitor& visitor) { ForEachInLeaves(first, end, visitor); });
+  }
+  return result;
 }
 
-void BPlusTree::CopyTree(const BPlusTree& other) {
-  if (&other != this) {
-    for (auto& element : other.AllElements()) {
-      Set(element);
+template <size_t Order>
+std::string BasicBPlusTree<Order>::Scan(const std::string& cursor, string prefix,
+                                        const ScanVisitor& visitor) const {
+  bool is_after;
+  const std::string from = ScanFrom(cursor, prefix, &is_after);
+  const Node* leaf = FindLeaf(from);
+  size_t number = LowerBound(leaf, from);
+  if (is_after && number < leaf->elements.size() && leaf->elements[number].GetKey() == from) ++number;
+  for (; leaf; leaf = leaf->next, number = 0) {
+    for (; number < leaf->elements.size(); ++number) {
+      const std::string& key = leaf->elements[number].GetKey();
+      if (!HasPrefix(key, prefix)) return "0";
+      if (!visitor(leaf->elements[number])) return OrderedCursor(key);
     }
   }
+  return "0";
 }
 
-BPlusTree::~BPlusTree() {
-  root_->DeleteNodesInTreeWithThisRoot();
-  delete root_;
-}
-
-BPlusTree::Node* BPlusTree::GetReferenceOfNodeForThisKeyFromNode(string key, Node* node)  const {
-  size_t number_of_closest = node->NumberOfKeyThatClosest(key);
-  if (node->GetChildren().size() > 0
-    && ((node->GetKeyelements().size() > number_of_closest
-        && node->GetKeyelements()[number_of_closest].GetKey() != key )
-        || node->GetKeyelements().size() == number_of_closest)) {
-    Node* child_with_this_key = node->GetChildren()[number_of_closest];
-    node = (GetReferenceOfNodeForThisKeyFromNode(key, child_with_this_key));
-  }
-  return node;
+template <size_t Order>
+void BasicBPlusTree<Order>::Init() {
+  DeleteNode(root_);
+  root_ = new Node(true);
 }
 
-void BPlusTree::DivideOnTwoNods(Node* node) {
-  std::vector<Element> keyelements_of_this_node = node->GetKeyelements();
-  int number_of_closest_in_parent = 0;
-  if (node->GetType() != Node::kRoot)
-    number_of_closest_in_parent =
-          node->GetParent()->NumberOfKeyThatClosest(keyelements_of_this_node[kOrder - 1].GetKey());
-  if (node->GetType() == Node::kRoot) {
-    DivideRoot(node);
-  } else {
-    DivideNotRoot(node);
-  }
-  if (node->GetChildren().size() > 0) DivideChildren(node, number_of_closest_in_parent);
-  if (node->GetParent()->GetKeyelements().size() == 2 * kOrder) DivideOnTwoNods(node->GetParent());
-}
-
-void BPlusTree::DivideRoot(Node* node) {
-    std::vector<Element> keyelements = node->GetKeyelements();
-    Node::TypeOfNode new_type = (node->GetChildren().size() == 0) ? Node::kList : Node::kNotList;
-    root_ = new Node(Node::kRoot);
-    root_->SetKeyelements({keyelements[kOrder - 1]});
-    node->SetType(new_type);
-    root_->SetChildren({node, new Node(new_type)});
-    root_->GetChildren()[1]->SetKeyelements(std::vector<Element>(keyelements.begin() + kOrder,
-                                                                  keyelements.end()));
-    node->SetKeyelements(std::vector<Element>(keyelements.begin(), keyelements.begin() + kOrder - 1));
-    node->SetParent(root_);
-    root_->GetChildren()[1]->SetParent(root_);
-}
-
-void BPlusTree::DivideNotRoot(Node* node) {
-    std::vector<Element> keyelements = node->GetKeyelements();
-    int number_of_closest = node->GetParent()->NumberOfKeyThatClosest(keyelements[kOrder - 1].GetKey());
-    node->GetParent()->InsertElementInNode(keyelements[kOrder - 1], node, new Node(node->GetType()));
-    std::vector<Element> keyelements_of_left = std::vector<Element>(keyelements.begin(),
-                                                                      keyelements.begin() + kOrder - 1);
-    std::vector<Element> keyelements_of_right =
-                          std::vector<Element>(keyelements.begin() + kOrder, keyelements.end());
-    node->GetParent()->GetChildren()[number_of_closest + 1]->SetKeyelements(keyelements_of_right);
-    node->SetKeyelements(keyelements_of_left);
-    node->GetParent()->GetChildren()[number_of_closest + 1]->SetParent(node->GetParent());
-}
-
-void BPlusTree::DivideChildren(Node* node, int number_of_closest) {
-  std::vector<Node*> children = node->GetChildren();
-  std::vector<Node*> children_of_left = std::vector<Node*>(children.begin(), children.begin() + kOrder);
-  std::vector<Node*> children_of_right = std::vector<Node*>(children.begin() + kOrder, children.end());
-  for (auto child : children_of_right)
-    child->SetParent(node->GetParent()->GetChildren()[number_of_closest + 1]);
-  node->GetParent()->GetChildren()[number_of_closest + 1]->SetChildren(children_of_right);
-  node->SetChildren(children_of_left);
+template <size_t Order>
+size_t BasicBPlusTree<Order>::Height() const {
+  size_t height = 1;
+  for (const Node* node = root_; !node->is_leaf; node = node->children[0]) ++height;
+  return height;
 }
 
 /* -------------------------------------------------------------------------- */
-/*                                   Node                                     */
+/*                                 BPlusTree                                  */
 /* -------------------------------------------------------------------------- */
 
-BPlusTree::Node::Node() {}
+template <size_t Order>
+BasicBPlusTree<Order>::BasicBPlusTree() : root_(new Node(true)) {}
 
-BPlusTree::Node::Node(TypeOfNode type) {
-  type_ = type;
-}
-
-BPlusTree::Node::Node(const Node& other) {
-  CopyNode(other);
-}
-
-BPlusTree::Node::Node(Node&& other) {
-  CopyNode(other);
-}
-BPlusTree::Node& BPlusTree::Node::operator=(const Node& other) {
-  CopyNode(other);
-  return *this;
-}
-BPlusTree::Node& BPlusTree::Node::operator=(const Node&& other) {
-  CopyNode(other);
-  return *this;
+template <size_t Order>
+BasicBPlusTree<Order>::BasicBPlusTree(const BasicBPlusTree& other) : root_(new Node(true)) {
+  CopyTree(other);
 }
 
-BPlusTree::Node::~Node() {}
-
-void BPlusTree::Node::CopyNode(const Node& other) {
-  keyelements_ = other.keyelements_;
-  SetChildren(other.children_);
-  parent_ = other.parent_;
-  type_ = other.type_;
+template <size_t Order>
+BasicBPlusTree<Order>::BasicBPlusTree(BasicBPlusTree&& other) : root_(new Node(true)) {
+  std::swap(root_, other.root_);
 }
 
-void BPlusTree::Node::SetKeyelements(const std::vector<Element>& keyelements) {
-  keyelements_.clear();
-  for (size_t i = 0; i < keyelements.size(); ++i) {
-    keyelements_.push_back(keyelements[i]);
+template <size_t Order>
+BasicBPlusTree<Order>& BasicBPlusTree<Order>::operator=(const BasicBPlusTree& other) {
+  if (&other != this) {
+    Init();
+    CopyTree(other);
   }
+  return *this;
 }
 
-void BPlusTree::Node::SetChildren(const std::vector<Node*>& children) {
-  children_.resize(children.size());
-  for (size_t i = 0; i < children.size(); ++i)
-    children_[i] = children[i];
-}
-
-void BPlusTree::Node::SetParent(Node* parent) {
-  parent_ = parent;
-}
-
-void BPlusTree::Node::SetType(TypeOfNode type) {
-  type_ = type;
+template <size_t Order>
+BasicBPlusTree<Order>& BasicBPlusTree<Order>::operator=(BasicBPlusTree&& other) {
+  std::swap(root_, other.root_);
+  return *this;
 }
 
-std::vector<BPlusTree::Node*> BPlusTree::Node::GetChildren() const {
-  return children_;
+template <size_t Order>
+void BasicBPlusTree<Order>::CopyTree(const BasicBPlusTree& other) {
+  other.ForEach([this](const Element& element) { Set(element); });
 }
 
-std::vector<BPlusTree::Element> BPlusTree::Node::GetKeyelements() const {
-  return keyelements_;
+template <size_t Order>
+BasicBPlusTree<Order>::~BasicBPlusTree() {
+  DeleteNode(root_);
 }
 
-BPlusTree::Node* BPlusTree::Node::GetParent() {
-  return parent_;
-}
+template <size_t Order>
+BasicBPlusTree<Order>::Node::Node(bool is_leaf) : is_leaf(is_leaf) {}
 
-BPlusTree::Node::TypeOfNode BPlusTree::Node::GetType() const {
-  return type_;
+template <size_t Order>
+void BasicBPlusTree<Order>::DeleteNode(Node* node) {
+  for (Node* child : node->children) DeleteNode(child);
+  delete node;
 }
 
-void BPlusTree::Node::CleanReferencesToChildren() {
-  for (auto child : children_) {
-    if (child != nullptr) delete child;
-    child = nullptr;
-  }
+/* the first record of a leaf not less than key */
+template <size_t Order>
+size_t BasicBPlusTree<Order>::LowerBound(const Node* leaf, string key) {
+  return Bound(leaf->heads, key, [leaf](size_t i) -> const std::string& { return leaf->elements[i].GetKey(); },
+               false);
 }
 
-void BPlusTree::Node::DeleteNodesInTreeWithThisRoot() {
-  if (children_.size() != 0 && children_[0]->GetType() != kList) {
-    for (auto child : children_) {
-      child->DeleteNodesInTreeWithThisRoot();
-    }
-    CleanReferencesToChildren();
-  } else {
-    CleanReferencesToChildren();
-  }
+/* the child of an inner node whose subtree may hold key */
+template <size_t Order>
+size_t BasicBPlusTree<Order>::ChildIndex(const Node* node, string key) {
+  return Bound(node->heads, key, [node](size_t i) -> const std::string& { return node->keys[i]; }, true);
 }
 
-int BPlusTree::Node::NumberOfKeyThatClosest(string key) const {
-  int count_of_keyelements = keyelements_.size();
-  for (int i = 0; i < count_of_keyelements; ++i) {
-    if (key <= keyelements_[i].GetKey()) return i;
-  }
-  return count_of_keyelements;
+template <size_t Order>
+typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::FindLeaf(string key) const {
+  Node* node = root_;
+  while (!node->is_leaf) node = node->children[ChildIndex(node, key)];
+  return node;
 }
 
-bool BPlusTree::Node::HasKey(string key) const {
-  if (std::any_of(keyelements_.begin(), keyelements_.end(), [&key](const Element& elem) {
-    return elem.GetKey() == key;
-  })) return true;
-  return false;
+template <size_t Order>
+const typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::FirstLeaf(const Node* node) {
+  while (!node->is_leaf) node = node->children.front();
+  return node;
 }
 
-void BPlusTree::Node::InsertElementInNode(const Element& element, Node* left_child, Node* right_child) {
-  int number_of_key = NumberOfKeyThatClosest(element.GetKey());
-  keyelements_.insert(keyelements_.begin() + number_of_key, element);
-  if (left_child && right_child) {
-    children_[number_of_key] = left_child;
-    children_.insert(children_.begin() + number_of_key + 1, right_child);
-  }
+template <size_t Order>
+const typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::LastLeaf(const Node* node) {
+  while (!node->is_leaf) node = node->children.back();
+  return node;
 }
 
-void BPlusTree::Node::InsertElementInNodeAtEnd(const Element& element, Node* child) {
-  int number_of_key = NumberOfKeyThatClosest(element.GetKey());
-  keyelements_.insert(keyelements_.begin() + number_of_key, element);
-  children_.insert(children_.begin() + number_of_key + 1, child);
+template <size_t Order>
+Storage::Element* BasicBPlusTree<Order>::FindElement(string key) const {
+  Node* leaf = FindLeaf(key);
+  const size_t number = LowerBound(leaf, key);
+  if (number < leaf->elements.size() && leaf->elements[number].GetKey() == key) return &leaf->elements[number];
+  return nullptr;
 }
 
-void BPlusTree::Node::InsertElementInNodeAtBegin(const Element& element, Node* child) {
-  int number_of_key = NumberOfKeyThatClosest(element.GetKey());
-  keyelements_.insert(keyelements_.begin() + number_of_key, element);
-  children_.insert(children_.begin() + number_of_key, child);
-}
+/* -------------------------------------------------------------------------- */
+/*                                  insert                                    */
+/* -------------------------------------------------------------------------- */
 
-void BPlusTree::Node::TakeAllKeyelements(std::vector<Element>* result, data_t data) {
-  for (auto element : keyelements_) {
-    if (data.life_time == kNullData) {
-      result->push_back(element);
-    } else {
-      if (IsDataSiutable(data, element.GetData())) result->push_back(element);
-    }
-  }
-  for (auto child : children_)
-    child->TakeAllKeyelements(result, data);
-}
-
-void BPlusTree::Node::DeleteKeyFromNotList(int number, Node* root) {
-  Node* node_for_change = GetListWithClosestRightKey(number + 1);
-  Element element_for_change = node_for_change->GetKeyelements()[0];
-  keyelements_[number] = element_for_change;
-  node_for_change->DeleteElement(element_for_change.GetKey());
-  if ((int)node_for_change->GetKeyelements().size() == kOrder - 2) {
-    if (node_for_change->parent_ != this) {
-      node_for_change->MakeBalance(0, root);
-    } else {
-      node_for_change->MakeBalance(number + 1, root);
-    }
+/* a key that is already there is left as it is */
+template <size_t Order>
+typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::Insert(Node* node, Element&& element,
+                                                                    std::string* separator) {
+  if (node->is_leaf) {
+    const size_t number = LowerBound(node, element.GetKey());
+    if (number < node->elements.size() && node->elements[number].GetKey() == element.GetKey()) return nullptr;
+    node->heads.insert(node->heads.begin() + number, Head(element.GetKey()));
+    node->elements.insert(node->elements.begin() + number, std::move(element));
+    return node->elements.size() > Order ? SplitLeaf(node, separator) : nullptr;
   }
+  const size_t number = ChildIndex(node, element.GetKey());
+  std::string child_separator;
+  Node* right = Insert(node->children[number], std::move(element), &child_separator);
+  if (!right) return nullptr;
+  node->heads.insert(node->heads.begin() + number, Head(child_separator));
+  node->keys.insert(node->keys.begin() + number, std::move(child_separator));
+  node->children.insert(node->children.begin() + number + 1, right);
+  return node->children.size() > Order ? SplitInner(node, separator) : nullptr;
+}
+
+template <size_t Order>
+typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::SplitLeaf(Node* leaf, std::string* separator) {
+  Node* right = new Node(true);
+  const size_t half = leaf->elements.size() / 2;
+  right->heads.assign(leaf->heads.begin() + half, leaf->heads.end());
+  leaf->heads.resize(half);
+  right->elements.reserve(Order + 1);
+  right->elements.insert(right->elements.end(), std::make_move_iterator(leaf->elements.begin() + half),
+                         std::make_move_iterator(leaf->elements.end()));
+  leaf->elements.erase(leaf->elements.begin() + half, leaf->elements.end());
+  *separator = right->elements.front().GetKey();
+  right->previous = leaf;
+  right->next = leaf->next;
+  if (leaf->next) leaf->next->previous = right;
+  leaf->next = right;
+  return right;
+}
+
+/* the separator between the halves goes up to the parent */
+template <size_t Order>
+typename BasicBPlusTree<Order>::Node* BasicBPlusTree<Order>::SplitInner(Node* node, std::string* separator) {
+  Node* right = new Node(false);
+  const size_t half = node->children.size() / 2;
+  right->children.assign(node->children.begin() + half, node->children.end());
+  node->children.resize(half);
+  *separator = std::move(node->keys[half - 1]);
+  right->keys.assign(std::make_move_iterator(node->keys.begin() + half), std::make_move_iterator(node->keys.end()));
+  node->keys.resize(half - 1);
+  right->heads.assign(node->heads.begin() + half, node->heads.end());
+  node->heads.resize(half - 1);
+  return right;
 }
 
-BPlusTree::Node* BPlusTree::Node::GetListWithClosestRightKey(int number) {
-  Node* node = children_[number];
-  while (node->type_ != kList) node = node->children_[0];
-  return node;
-}
+/* -------------------------------------------------------------------------- */
+/*                                   load                                     */
+/* -------------------------------------------------------------------------- */
 
-void BPlusTree::Node::DeleteKeyFromList(string key, Node* root) {
-  size_t number_of_child_in_parent = parent_->NumberOfKeyThatClosest(key);
-  if (GetKeyelements().size() > kOrder - 1) {
-    DeleteElement(key);
-  } else {
-    DeleteElement(key);
-    MakeBalance(number_of_child_in_parent, root);
-  }
+template <size_t Order>
+bool BasicBPlusTree<Order>::IsBulkLoaded() const {
+  return true;
 }
 
-void BPlusTree::Node::MakeBalance(size_t number_of_child_in_parent, Node* root) {
-  if (number_of_child_in_parent > 0
-    && parent_->GetChildren()[number_of_child_in_parent - 1]->GetKeyelements().size() > kOrder - 1) {
-  ChangeElementsWithLeftBrother(number_of_child_in_parent);
-  } else if (number_of_child_in_parent < parent_->GetChildren().size() - 1
-    && parent_->GetChildren()[number_of_child_in_parent + 1]->GetKeyelements().size() > kOrder - 1) {
-    ChangeElementsWithRightBrother(number_of_child_in_parent);
-  } else {
-    UnitWithBrother(number_of_child_in_parent, root);
+/* Every level is cut into as few nodes as the order allows with the
+   entries shared evenly, so the last node is not left short: the nodes are
+   more than half full and the tree is as low as it gets. The first key of
+   every node goes up as the separator in front of it. */
+template <size_t Order>
+void BasicBPlusTree<Order>::Load(std::vector<Element>* elements) {
+  SortByKey(elements);
+  if (elements->empty()) return;
+  DeleteNode(root_);
+  std::vector<Node*> level;
+  std::vector<std::string> firsts;
+  size_t count = elements->size();
+  size_t nodes = (count + Order - 1) / Order;
+  Node* previous = nullptr;
+  for (size_t i = 0; i < nodes; ++i) {
+    Node* leaf = new Node(true);
+    leaf->elements.reserve(Order + 1);
+    leaf->elements.assign(std::make_move_iterator(elements->begin() + i * count / nodes),
+                          std::make_move_iterator(elements->begin() + (i + 1) * count / nodes));
+    for (const auto& element : leaf->elements) leaf->heads.push_back(Head(element.GetKey()));
+    firsts.push_back(leaf->elements.front().GetKey());
+    leaf->previous = previous;
+    if (previous) previous->next = leaf;
+    previous = leaf;
+    level.push_back(leaf);
   }
-}
-
-void BPlusTree::Node::DeleteElement(string key) {
-  std::vector<Element> old_keys = GetKeyelements();
-  std::vector<Element> new_keys;
-  for (auto element : old_keys)
-    if (element.GetKey() != key) new_keys.push_back(element);
-  SetKeyelements(new_keys);
-  if (children_.size() > 0) {
-    size_t number_of_closest = NumberOfKeyThatClosest(key);
-    std::vector<Node*> new_children;
-    for (size_t i = 0; i < children_.size(); ++i) {
-      if (i != number_of_closest) {
-      new_children.push_back(children_[i]);
+  while (level.size() > 1) {
+    count = level.size();
+    nodes = (count + Order - 1) / Order;
+    std::vector<Node*> upper;
+    std::vector<std::string> upper_firsts;
+    for (size_t i = 0; i < nodes; ++i) {
+      const size_t begin = i * count / nodes;
+      const size_t end = (i + 1) * count / nodes;
+      Node* node = new Node(false);
+      node->children.assign(level.begin() + begin, level.begin() + end);
+      for (size_t j = begin + 1; j < end; ++j) {
+        node->heads.push_back(Head(firsts[j]));
+        node->keys.push_back(std::move(firsts[j]));
       }
+      upper_firsts.push_back(std::move(firsts[begin]));
+      upper.push_back(node);
     }
-    SetChildren(new_children);
+    level.swap(upper);
+    firsts.swap(upper_firsts);
   }
+  root_ = level.front();
 }
 
-void BPlusTree::Node::DeleteElementAtLeft(string key) {
-  std::vector<Element> old_keys = GetKeyelements();
-  std::vector<Element> new_keys;
-  for (auto element : old_keys)
-    if (element.GetKey() != key) new_keys.push_back(element);
-  SetKeyelements(new_keys);
-  if (children_.size() > 0) {
-    size_t number_of_closest = NumberOfKeyThatClosest(key);
-    std::vector<Node*> new_children;
-    for (size_t i = 0; i < children_.size(); ++i) {
-      if (i != number_of_closest + 1) {
-      new_children.push_back(children_[i]);
-      }
-    }
-    SetChildren(new_children);
-  }
-}
-
-void BPlusTree::Node::ChangeElementsWithLeftBrother(size_t number_of_child_in_parent) {
-    size_t number_of_brother = number_of_child_in_parent - 1;
-    Node* left_brother = parent_->GetChildren()[number_of_brother];
-    if (type_ == Node::kList) {
-      Element element_for_insert = parent_->GetKeyelements()[number_of_brother];
-      InsertElementInNode(element_for_insert, nullptr, nullptr);
-      std::vector<Element> keyelements_of_brother = left_brother->GetKeyelements();
-      Element element_for_parent = keyelements_of_brother[keyelements_of_brother.size() - 1];
-      parent_->ChangeKeyelement(number_of_brother, element_for_parent);
-      left_brother->DeleteElement(element_for_parent.GetKey());
-    } else {
-      Element element_for_insert = parent_->GetKeyelements()[number_of_brother];
-      InsertElementInNodeAtBegin(element_for_insert,
-      left_brother->GetChildren()[left_brother->GetChildren().size() - 1]);
-      std::vector<Element> keyelements_of_brother = left_brother->GetKeyelements();
-      Element element_for_parent = keyelements_of_brother[keyelements_of_brother.size() - 1];
-      parent_->ChangeKeyelement(number_of_brother, element_for_parent);
-      left_brother->DeleteElementAtLeft(element_for_parent.GetKey());
-      children_[0]->SetParent(this);
-    }
-}
-
-void BPlusTree::Node::ChangeElementsWithRightBrother(size_t number_of_node) {
-  Node* right_brother = parent_->GetChildren()[number_of_node + 1];
-    if (type_ == Node::kList) {
-      Element element_for_insert = parent_->GetKeyelements()[number_of_node];
-      InsertElementInNode(element_for_insert, nullptr, nullptr);
-      std::vector<Element> keyelements_of_brother = right_brother->GetKeyelements();
-      Element element_for_parent = keyelements_of_brother[0];
-      parent_->ChangeKeyelement(number_of_node, element_for_parent);
-      right_brother->DeleteElement(element_for_parent.GetKey());
-    } else {
-      Element element_for_insert = parent_->GetKeyelements()[number_of_node];
-      InsertElementInNodeAtEnd(element_for_insert, right_brother->GetChildren()[0]);
-      std::vector<Element> keyelements_of_brother = right_brother->GetKeyelements();
-      Element element_for_parent = keyelements_of_brother[0];
-
-      parent_->ChangeKeyelement(number_of_node, element_for_parent);
-      right_brother->DeleteElement(element_for_parent.GetKey());
-      children_[children_.size() - 1]->SetParent(this);
-    }
-}
-
-void BPlusTree::Node::ChangeKeyelement(int number, const Element& element_for_change) {
-  keyelements_[number] = element_for_change;
-}
+/* -------------------------------------------------------------------------- */
+/*                                  erase                                     */
+/* -------------------------------------------------------------------------- */
 
-void BPlusTree::Node::UnitWithBrother(size_t number_of_child_in_parent, Node* root) {
-  if (parent_->GetType() == kRoot && parent_->GetKeyelements().size() == 1) {
-    MakeNewRoot(root);
-  } else {
-    if (number_of_child_in_parent > 0) {
-      UnitWithLeftBrother(number_of_child_in_parent, root);
-    } else if (type_ != Node::kRoot) {
-      UnitWithRightBrother(number_of_child_in_parent, root);
-    }
+template <size_t Order>
+bool BasicBPlusTree<Order>::Erase(Node* node, string key, bool* is_erased) {
+  if (node->is_leaf) {
+    const size_t number = LowerBound(node, key);
+    if (number == node->elements.size() || node->elements[number].GetKey() != key) return false;
+    node->heads.erase(node->heads.begin() + number);
+    node->elements.erase(node->elements.begin() + number);
+    *is_erased = true;
+    return node->elements.size() < kMinElements;
   }
-}
-
-void BPlusTree::Node::UnitWithLeftBrother(size_t number_of_child_in_parent, Node* root) {
-  int number_of_brother = number_of_child_in_parent - 1;
-  Node* left_brother = parent_->GetChildren()[number_of_brother];
-  if (type_ == Node::kList) {
-    std::vector<Element> elements_of_brother = left_brother->GetKeyelements();
-    Element element_from_parent_for_insert = parent_->GetKeyelements()[number_of_brother];
-    InsertElementInNode(element_from_parent_for_insert, nullptr, nullptr);
-    elements_of_brother.insert(elements_of_brother.end(), keyelements_.begin(), keyelements_.end());
-    keyelements_ = elements_of_brother;
-    if (parent_->GetKeyelements().size() == kOrder - 1 && parent_->GetType() != Node::kRoot) {
-      size_t number_of_parent =
-             parent_->GetParent()->NumberOfKeyThatClosest(parent_->GetKeyelements()[0].GetKey());
-      parent_->DeleteElement(element_from_parent_for_insert.GetKey());
-      parent_->MakeBalance(number_of_parent, root);
+  const size_t number = ChildIndex(node, key);
+  if (Erase(node->children[number], key, is_erased)) Rebalance(node, number);
+  return node->children.size() < kMinChildren;
+}
+
+/* A sibling with more than the minimum gives its nearest entry, the
+   separator between them moves along. Otherwise the two are merged into
+   one node of at most Order entries. Separators stay valid bounds after a
+   removal, they need not be keys of records. */
+template <size_t Order>
+void BasicBPlusTree<Order>::Rebalance(Node* node, size_t i) {
+  Node* child = node->children[i];
+  Node* left = i > 0 ? node->children[i - 1] : nullptr;
+  Node* right = i + 1 < node->children.size() ? node->children[i + 1] : nullptr;
+  if (child->is_leaf) {
+    if (left && left->elements.size() > kMinElements) {
+      child->heads.insert(child->heads.begin(), left->heads.back());
+      child->elements.insert(child->elements.begin(), std::move(left->elements.back()));
+      left->heads.pop_back();
+      left->elements.pop_back();
+      node->keys[i - 1] = child->elements.front().GetKey();
+      node->heads[i - 1] = child->heads.front();
+    } else if (right && right->elements.size() > kMinElements) {
+      child->heads.push_back(right->heads.front());
+      child->elements.push_back(std::move(right->elements.front()));
+      right->heads.erase(right->heads.begin());
+      right->elements.erase(right->elements.begin());
+      node->keys[i] = right->elements.front().GetKey();
+      node->heads[i] = right->heads.front();
     } else {
-      parent_->DeleteElement(element_from_parent_for_insert.GetKey());
+      Merge(node, left ? i - 1 : i);
     }
-    delete left_brother;
-    left_brother = nullptr;
+    return;
+  }
+  if (left && left->children.size() > kMinChildren) {
+    child->keys.insert(child->keys.begin(), std::move(node->keys[i - 1]));
+    child->heads.insert(child->heads.begin(), node->heads[i - 1]);
+    child->children.insert(child->children.begin(), left->children.back());
+    node->keys[i - 1] = std::move(left->keys.back());
+    node->heads[i - 1] = left->heads.back();
+    left->keys.pop_back();
+    left->heads.pop_back();
+    left->children.pop_back();
+  } else if (right && right->children.size() > kMinChildren) {
+    child->keys.push_back(std::move(node->keys[i]));
+    child->heads.push_back(node->heads[i]);
+    child->children.push_back(right->children.front());
+    node->keys[i] = std::move(right->keys.front());
+    node->heads[i] = right->heads.front();
+    right->keys.erase(right->keys.begin());
+    right->heads.erase(right->heads.begin());
+    right->children.erase(right->children.begin());
   } else {
-    std::vector<Element> elements_of_brother = left_brother->GetKeyelements();
-    std::vector<Node*> children_of_brother = left_brother->GetChildren();
-    Element element_from_parent_for_insert = parent_->GetKeyelements()[number_of_brother];
-    InsertElementInNode(element_from_parent_for_insert, nullptr, nullptr);
-    elements_of_brother.insert(elements_of_brother.end(), keyelements_.begin(), keyelements_.end());
-    children_of_brother.insert(children_of_brother.end(), children_.begin(), children_.end());
-    keyelements_ = elements_of_brother;
-    children_ = children_of_brother;
-    for (auto ch : children_)
-       ch->SetParent(this);
-    if (parent_->GetKeyelements().size() == kOrder - 1 && parent_->GetType() != Node::kRoot) {
-      size_t number_of_parent =
-             parent_->GetParent()->NumberOfKeyThatClosest(parent_->GetKeyelements()[0].GetKey());
-      parent_->DeleteElement(element_from_parent_for_insert.GetKey());
-      parent_->MakeBalance(number_of_parent, root);
-    } else {
-      parent_->DeleteElement(element_from_parent_for_insert.GetKey());
-    }
-    delete left_brother;
-    left_brother = nullptr;
+    Merge(node, left ? i - 1 : i);
   }
 }
 
-void BPlusTree::Node::UnitWithRightBrother(size_t number_of_node, Node* root) {
-  Node* right_brother = parent_->GetChildren()[number_of_node + 1];
-  if (type_ == Node::kList) {
-    std::vector<Element> elements_of_brother = right_brother->GetKeyelements();
-    Element element_from_parent_for_insert = parent_->GetKeyelements()[number_of_node];
-    InsertElementInNode(element_from_parent_for_insert, nullptr, nullptr);
-    keyelements_.insert(keyelements_.end(), elements_of_brother.begin(), elements_of_brother.end());
-    if (parent_->GetKeyelements().size() == kOrder - 1 && parent_->GetType() != Node::kRoot) {
-      size_t number_of_parent =
-             parent_->GetParent()->NumberOfKeyThatClosest(parent_->GetKeyelements()[0].GetKey());
-      parent_->DeleteElementAtLeft(element_from_parent_for_insert.GetKey());
-      parent_->MakeBalance(number_of_parent, root);
-    } else {
-      parent_->DeleteElementAtLeft(element_from_parent_for_insert.GetKey());
-    }
-    delete right_brother;
-    right_brother = nullptr;
+/* child i + 1 joins child i */
+template <size_t Order>
+void BasicBPlusTree<Order>::Merge(Node* node, size_t i) {
+  Node* left = node->children[i];
+  Node* right = node->children[i + 1];
+  if (left->is_leaf) {
+    left->elements.insert(left->elements.end(), std::make_move_iterator(right->elements.begin()),
+                          std::make_move_iterator(right->elements.end()));
+    left->heads.insert(left->heads.end(), right->heads.begin(), right->heads.end());
+    left->next = right->next;
+    if (right->next) right->next->previous = left;
   } else {
-    std::vector<Element> elements_of_brother = right_brother->GetKeyelements();
-    std::vector<Node*> children_of_brother = right_brother->GetChildren();
-    Element element_from_parent_for_insert = parent_->GetKeyelements()[number_of_node];
-    InsertElementInNode(element_from_parent_for_insert, nullptr, nullptr);
-    keyelements_.insert(keyelements_.end(), elements_of_brother.begin(), elements_of_brother.end());
-    children_.insert(children_.end(), children_of_brother.begin(), children_of_brother.end());
-    for (auto ch : children_)
-       ch->SetParent(this);
-    if (parent_->GetKeyelements().size() == kOrder - 1 && parent_->GetType() != Node::kRoot) {
-      size_t number_of_parent =
-             parent_->GetParent()->NumberOfKeyThatClosest(parent_->GetKeyelements()[0].GetKey());
-      parent_->DeleteElementAtLeft(element_from_parent_for_insert.GetKey());
-      parent_->MakeBalance(number_of_parent, root);
-    } else {
-      parent_->DeleteElementAtLeft(element_from_parent_for_insert.GetKey());
-    }
-    delete right_brother;
-    right_brother = nullptr;
+    left->keys.push_back(std::move(node->keys[i]));
+    left->keys.insert(left->keys.end(), std::make_move_iterator(right->keys.begin()),
+                      std::make_move_iterator(right->keys.end()));
+    left->heads.push_back(node->heads[i]);
+    left->heads.insert(left->heads.end(), right->heads.begin(), right->heads.end());
+    left->children.insert(left->children.end(), right->children.begin(), right->children.end());
   }
+  node->keys.erase(node->keys.begin() + i);
+  node->heads.erase(node->heads.begin() + i);
+  node->children.erase(node->children.begin() + i + 1);
+  delete right;
 }
 
-void BPlusTree::Node::MakeNewRoot(Node* root) {
-  std::vector<Element> elements_in_left = root->GetChildren()[0]->GetKeyelements();
-  std::vector<Element> elements_in_right = root->GetChildren()[1]->GetKeyelements();
-  std::vector<Node*> children_in_left = root->GetChildren()[0]->GetChildren();
-  std::vector<Node*> children_in_right = root->GetChildren()[1]->GetChildren();
-  children_in_left.insert(children_in_left.end(), children_in_right.begin(), children_in_right.end());
-  elements_in_left.insert(elements_in_left.end(), root->GetKeyelements()[0]);
-  elements_in_left.insert(elements_in_left.end(), elements_in_right.begin(), elements_in_right.end());
-  delete root->GetChildren()[0];
-  delete root->GetChildren()[1];
-  *root = Node(kRoot);
-  (root)->SetKeyelements(elements_in_left);
-  (root)->SetChildren(children_in_left);
-  for (auto el : children_in_left) el->SetParent(root);
+/* -------------------------------------------------------------------------- */
+/*                                   walks                                    */
+/* -------------------------------------------------------------------------- */
+
+template <size_t Order>
+void BasicBPlusTree<Order>::ForEachInLeaves(const Node* first, const Node* end, const Visitor& visitor) {
+  for (const Node* leaf = first; leaf != end; leaf = leaf->next) {
+    for (const auto& element : leaf->elements) visitor(element);
+  }
 }
 
 /* -------------------------------------------------------------------------- */
 /*                                vizualization                               */
 /* -------------------------------------------------------------------------- */
 
-void BPlusTree::TreeViz(string file_name) {
+template <size_t Order>
+void BasicBPlusTree<Order>::TreeViz(string file_name) {
   std::ofstream out_stream;
   out_stream.open(file_name + ".gv", std::ios::trunc);
   out_stream << "digraph {\nnode [margin=0 fontsize=8 width=0.5 shape=box]\n";
@@ -607,23 +536,27 @@ void BPlusTree::TreeViz(string file_name) {
   out_stream << "}";
 }
 
-void BPlusTree::PrintNode(Node* node, std::ofstream* out_stream) {
-  if (node && node->GetKeyelements().size() > 0) {
-      *out_stream << "\"" << node->GetKeyelements()[0].GetKey() << "\"" << "[label=\"";
-      for (auto el : node->GetKeyelements())
-        *out_stream << el.GetKey() << "; ";
-      *out_stream << "\"color=grey, style=filled, shape=circle]\n";
-      if (node->GetChildren().size() > 0) {
-        for (auto child : node->GetChildren()) {
-          *out_stream << "\"" << node->GetKeyelements()[0].GetKey() << "\"" << "->" "\""
-                      << child->GetKeyelements()[0].GetKey() << "\"\n";
-        }
-      }
-      if (node->GetParent()) {
-        *out_stream << "\"" << node->GetKeyelements()[0].GetKey() << "\"" << "->" "\""
-                    << node->GetParent()->GetKeyelements()[0].GetKey() << "\"[style=dotted, color=grey]\n";
-      }
-      for (auto child : node->GetChildren()) PrintNode(child, out_stream);
+template <size_t Order>
+void BasicBPlusTree<Order>::PrintNode(const Node* node, std::ofstream* out_stream) const {
+  *out_stream << "\"" << node << "\"" << "[label=\"";
+  if (node->is_leaf) {
+    for (const auto& element : node->elements) *out_stream << element.GetKey() << "; ";
+  } else {
+    for (const auto& key : node->keys) *out_stream << key << "; ";
+  }
+  *out_stream << "\"color=grey, style=filled, shape=" << (node->is_leaf ? "box" : "circle") << "]\n";
+  for (const Node* child : node->children) {
+    *out_stream << "\"" << node << "\"" << "->" "\"" << child << "\"\n";
+    PrintNode(child, out_stream);
   }
 }
+
+/* the orders COMPARE sweeps */
+template class BasicBPlusTree<4>;
+template class BasicBPlusTree<8>;
+template class BasicBPlusTree<16>;
+template class BasicBPlusTree<32>;
+template class BasicBPlusTree<64>;
+template class BasicBPlusTree<128>;
+
 }  // namespace s21
@@ -0,0 +1,301 @@
+#include "concurrent_hash_table.h"
+#include "epoch.h"
+#include "key_hash.h"
+
+namespace s21 {
+
+using data_t = Storage::Element::Data;
+
+ConcurrentHashTable::ConcurrentHashTable() : shards_(new Shard[kShardCount]) {
+  for (size_t i = 0; i < kShardCount; ++i) shards_[i].buckets.store(new Buckets(kMinBuckets));
+}
+
+ConcurrentHashTable::ConcurrentHashTable(ConcurrentHashTable const& other)
+  : ConcurrentHashTable() {
+  CopyTable(other);
+}
+
+ConcurrentHashTable::ConcurrentHashTable(ConcurrentHashTable&& other)
+  : ConcurrentHashTable() {
+  std::swap(shards_, other.shards_);
+}
+
+ConcurrentHashTable& ConcurrentHashTable::operator=(ConcurrentHashTable const& other) {
+  CopyTable(other);
+  return *this;
+}
+
+ConcurrentHashTable& ConcurrentHashTable::operator=(ConcurrentHashTable&& other) {
+  if (&other != this) std::swap(shards_, other.shards_);
+  return *this;
+}
+
+/* nobody may read a table that is being destroyed, so nothing is retired */
+ConcurrentHashTable::~ConcurrentHashTable() {
+  Release();
+}
+
+inline void ConcurrentHashTable::CopyTable(ConcurrentHashTable const& other) {
+  if (&other != this) {
+    Init();
+    other.ForEach([this](const Element& element) { Set(element); });
+  }
+}
+
+void ConcurrentHashTable::Release() {
+  for (size_t i = 0; i < kShardCount; ++i) {
+    DeleteNodesAndElements(shards_[i].buckets.exchange(nullptr));
+  }
+}
+
+void ConcurrentHashTable::Set(element element) {
+  Set(Element(element));
+}
+
+void ConcurrentHashTable::Set(Element&& element) {
+  const uint64_t hash = HashFunction(element.GetKey());
+  Shard& shard = ShardAt(hash);
+  std::lock_guard lock(shard.mutex);
+  if (!FindNode(shard, element.GetKey(), hash)) Insert(&shard, new Element(std::move(element)), hash);
+}
+
+Storage::Element ConcurrentHashTable::Get(string key) const {
+  const uint64_t hash = HashFunction(key);
+  Epoch::Guard guard;
+  const Node* node = FindNode(ShardAt(hash), key, hash);
+  if (!node) return Element();
+  return *node->element.load(std::memory_order_acquire);
+}
+
+bool ConcurrentHashTable::Visit(string key, const Visitor& visitor) const {
+  const uint64_t hash = HashFunction(key);
+  Epoch::Guard guard;
+  const Node* node = FindNode(ShardAt(hash), key, hash);
+  if (!node) return false;
+  visitor(*node->element.load(std::memory_order_acquire));
+  return true;
+}
+
+bool ConcurrentHashTable::Exists(string key) const {
+  const uint64_t hash = HashFunction(key);
+  Epoch::Guard guard;
+  return FindNode(ShardAt(hash), key, hash) != nullptr;
+}
+
+bool ConcurrentHashTable::Del(string key) {
+  const uint64_t hash = HashFunction(key);
+  Shard& shard = ShardAt(hash);
+  std::lock_guard lock(shard.mutex);
+  return Erase(&shard, key, hash);
+}
+
+/* readers may hold the current record, so the change goes to a copy */
+bool ConcurrentHashTable::Update(string key, const data_t& data) {
+  const uint64_t hash = HashFunction(key);
+  Shard& shard = ShardAt(hash);
+  std::lock_guard lock(shard.mutex);
+  std::atomic<Node*>* link = FindLink(shard.buckets.load(std::memory_order_relaxed), key, hash);
+  if (!link) return false;
+  Node* node = link->load(std::memory_order_relaxed);
+  const Element* old_element = node->element.load(std::memory_order_relaxed);
+  Element* element = new Element(*old_element);
+  element->UpdateData(data);
+  node->element.store(element, std::memory_order_release);
+  Epoch::Retire(const_cast<Element*>(old_element));
+  return true;
+}
+
+/* a key moving to another shard locks both, std::lock orders them so two
+   opposite renames cannot deadlock */
+bool ConcurrentHashTable::Rename(string key, string new_key) {
+  const uint64_t hash = HashFunction(key);
+  const uint64_t new_hash = HashFunction(new_key);
+  Shard& source = ShardAt(hash);
+  Shard& destination = ShardAt(new_hash);
+  std::unique_lock<std::mutex> source_lock(source.mutex, std::defer_lock);
+  std::unique_lock<std::mutex> destination_lock(destination.mutex, std::defer_lock);
+  if (&source == &destination) {
+    source_lock.lock();
+  } else {
+    std::lock(source_lock, destination_lock);
+  }
+  std::atomic<Node*>* link = FindLink(source.buckets.load(std::memory_order_relaxed), key, hash);
+  if (!link) return false;
+  if (key == new_key) return true;
+  if (FindLink(destination.buckets.load(std::memory_order_relaxed), new_key, new_hash)) return false;
+  Element* element = new Element(*link->load(std::memory_order_relaxed)->element.load());
+  element->SetKey(new_key);
+  Insert(&destination, element, new_hash);
+  Erase(&source, key, hash);
+  return true;
+}
+
+int ConcurrentHashTable::Ttl(string key) const {
+  const uint64_t hash = HashFunction(key);
+  Epoch::Guard guard;
+  const Node* node = FindNode(ShardAt(hash), key, hash);
+  if (!node) return 0;
+  return node->element.load(std::memory_order_acquire)->GetLifeTime();
+}
+
+/* the whole walk is one pinned epoch, a slow visitor delays reclamation */
+void ConcurrentHashTable::ForEach(const Visitor& visitor) const {
+  Epoch::Guard guard;
+  for (size_t i = 0; i < kShardCount; ++i) {
+    const Buckets* buckets = shards_[i].buckets.load(std::memory_order_acquire);
+    for (size_t j = 0; j <= buckets->mask; ++j) {
+      for (Node* node = buckets->heads[j].load(std::memory_order_acquire); node;
+           node = node->next.load(std::memory_order_acquire)) {
+        visitor(*node->element.load(std::memory_order_acquire));
+      }
+    }
+  }
+}
+
+std::string ConcurrentHashTable::Scan(const std::string& cursor, string, const ScanVisitor& visitor) const {
+  const size_t position = ParseCursor(cursor);
+  size_t shard = position % kShardCount;
+  size_t bucket = position / kShardCount;
+  bool is_more = true;
+  Epoch::Guard guard;
+  while (is_more && shard < kShardCount) {
+    const Buckets* buckets = shards_[shard].buckets.load(std::memory_order_acquire);
+    for (Node* node = buckets->heads[bucket & buckets->mask].load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+      is_more = visitor(*node->element.load(std::memory_order_acquire)) && is_more;
+    }
+    bucket = NextBucket(bucket, buckets->mask);
+    if (bucket == 0) ++shard;
+  }
+  return shard == kShardCount ? "0" : std::to_string(bucket * kShardCount + shard);
+}
+
+void ConcurrentHashTable::Init() {
+  for (size_t i = 0; i < kShardCount; ++i) {
+    std::lock_guard lock(shards_[i].mutex);
+    Buckets* old_buckets = shards_[i].buckets.exchange(new Buckets(kMinBuckets));
+    shards_[i].size = 0;
+    Epoch::Retire(old_buckets, &DeleteNodesAndElements);
+  }
+}
+
+bool ConcurrentHashTable::IsThreadSafe() const {
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   shards                                   */
+/* -------------------------------------------------------------------------- */
+
+ConcurrentHashTable::Buckets::Buckets(size_t size)
+  : mask(size - 1), heads(new std::atomic<Node*>[size]) {
+  for (size_t i = 0; i < size; ++i) heads[i].store(nullptr, std::memory_order_relaxed);
+}
+
+uint64_t ConcurrentHashTable::HashFunction(const std::string& key) {
+  return KeyHash::Hash(key);
+}
+
+/* the low bits of the hash pick the shard, the high ones the bucket */
+ConcurrentHashTable::Shard& ConcurrentHashTable::ShardAt(uint64_t hash) const {
+  return shards_[hash & (kShardCount - 1)];
+}
+
+std::atomic<ConcurrentHashTable::Node*>& ConcurrentHashTable::BucketAt(const Buckets* buckets,
+                                                                       uint64_t hash) {
+  return buckets->heads[(hash >> 32) & buckets->mask];
+}
+
+const ConcurrentHashTable::Node* ConcurrentHashTable::FindNode(const Shard& shard, string key,
+                                                               uint64_t hash) {
+  const Buckets* buckets = shard.buckets.load(std::memory_order_acquire);
+  for (const Node* node = BucketAt(buckets, hash).load(std::memory_order_acquire); node;
+       node = node->next.load(std::memory_order_acquire)) {
+    if (node->hash == hash && node->element.load(std::memory_order_acquire)->GetKey() == key) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+/* writers only: the link that points to the node of the key */
+std::atomic<ConcurrentHashTable::Node*>* ConcurrentHashTable::FindLink(Buckets* buckets, string key,
+                                                                      uint64_t hash) {
+  std::atomic<Node*>* link = &BucketAt(buckets, hash);
+  for (Node* node = link->load(std::memory_order_relaxed); node;
+       node = node->next.load(std::memory_order_relaxed)) {
+    if (node->hash == hash && node->element.load(std::memory_order_relaxed)->GetKey() == key) {
+      return link;
+    }
+    link = &node->next;
+  }
+  return nullptr;
+}
+
+/* the node is filled in before the release store makes it reachable */
+void ConcurrentHashTable::Insert(Shard* shard, const Element* element, uint64_t hash) {
+  Buckets* buckets = shard->buckets.load(std::memory_order_relaxed);
+  if (shard->size + 1 > buckets->mask + 1) {
+    Grow(shard);
+    buckets = shard->buckets.load(std::memory_order_relaxed);
+  }
+  std::atomic<Node*>& head = BucketAt(buckets, hash);
+  head.store(new Node{hash, element, head.load(std::memory_order_relaxed)},
+             std::memory_order_release);
+  ++shard->size;
+}
+
+/* the unlinked node keeps its next pointer, readers standing on it go on */
+bool ConcurrentHashTable::Erase(Shard* shard, string key, uint64_t hash) {
+  std::atomic<Node*>* link = FindLink(shard->buckets.load(std::memory_order_relaxed), key, hash);
+  if (!link) return false;
+  Node* node = link->load(std::memory_order_relaxed);
+  link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+  Epoch::Retire(const_cast<Element*>(node->element.load(std::memory_order_relaxed)));
+  Epoch::Retire(node);
+  --shard->size;
+  return true;
+}
+
+/* readers may be walking the old chains, so the new array gets new nodes
+   that share the records; the old nodes are retired, the records are not */
+void ConcurrentHashTable::Grow(Shard* shard) {
+  Buckets* old_buckets = shard->buckets.load(std::memory_order_relaxed);
+  Buckets* buckets = new Buckets((old_buckets->mask + 1) * 2);
+  for (size_t i = 0; i <= old_buckets->mask; ++i) {
+    for (Node* node = old_buckets->heads[i].load(std::memory_order_relaxed); node;
+         node = node->next.load(std::memory_order_relaxed)) {
+      std::atomic<Node*>& head = BucketAt(buckets, node->hash);
+      head.store(new Node{node->hash, node->element.load(std::memory_order_relaxed),
+                          head.load(std::memory_order_relaxed)}, std::memory_order_relaxed);
+    }
+  }
+  shard->buckets.store(buckets, std::memory_order_release);
+  Epoch::Retire(old_buckets, &DeleteNodes);
+}
+
+void ConcurrentHashTable::DeleteNodes(void* pointer) {
+  Buckets* buckets = static_cast<Buckets*>(pointer);
+  for (size_t i = 0; i <= buckets->mask; ++i) {
+    Node* node = buckets->heads[i].load(std::memory_order_relaxed);
+    while (node) {
+      Node* next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+  delete buckets;
+}
+
+void ConcurrentHashTable::DeleteNodesAndElements(void* pointer) {
+  Buckets* buckets = static_cast<Buckets*>(pointer);
+  if (!buckets) return;
+  for (size_t i = 0; i <= buckets->mask; ++i) {
+    for (Node* node = buckets->heads[i].load(std::memory_order_relaxed); node;
+         node = node->next.load(std::memory_order_relaxed)) {
+      delete node->element.load(std::memory_order_relaxed);
+    }
+  }
+  DeleteNodes(buckets);
+}
+}  // namespace s21
@@ -0,0 +1,87 @@
+#ifndef SRC_CONTAINERS_CONCURRENT_HASH_TABLE_H_
+#define SRC_CONTAINERS_CONCURRENT_HASH_TABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "../storage.h"
+
+namespace s21 {
+
+/* Lock striping for writers, no locks for readers. Keys are spread over a
+   fixed number of shards, each one a chained hash table whose writers take
+   the shard mutex. Readers pin an epoch and walk the chains through atomic
+   pointers: a record is never changed in place, UPDATE publishes a new copy
+   and unlinked nodes and records are retired to Epoch, so a reader never
+   sees freed memory. Whole-table operations see each shard, not the table,
+   at a single moment. */
+class ConcurrentHashTable : public Storage {
+ public:
+  using data_t = Storage::Element::Data;
+
+  ConcurrentHashTable();
+  ConcurrentHashTable(ConcurrentHashTable const&);
+  ConcurrentHashTable(ConcurrentHashTable&&);
+  ConcurrentHashTable& operator=(ConcurrentHashTable const&);
+  ConcurrentHashTable& operator=(ConcurrentHashTable&&);
+  ~ConcurrentHashTable();
+  void Set(element element) override;
+  void Set(Element&& element) override;
+  Element Get(string key) const override;
+  bool Visit(string key, const Visitor& visitor) const override;
+  void ForEach(const Visitor& visitor) const override;
+  /* the cursor is a shard in the low bits and a bucket of it above them,
+     see Storage::NextBucket */
+  std::string Scan(const std::string& cursor, string prefix, const ScanVisitor& visitor) const override;
+  bool Exists(string key) const override;
+  bool Del(string key) override;
+  bool Update(string key, const data_t& data) override;
+  bool Rename(string key, string new_key) override;
+  int Ttl(string key) const override;
+  void Init() override;
+  bool IsThreadSafe() const override;
+
+ private:
+  static constexpr size_t kShardCount = 64;
+  static constexpr size_t kMinBuckets = 16;
+
+  struct Node {
+    uint64_t hash;
+    std::atomic<const Element*> element;
+    std::atomic<Node*> next;
+  };
+
+  /* the bucket array of a shard is replaced as a whole when it grows, the
+     old one stays readable until it is reclaimed */
+  struct Buckets {
+    explicit Buckets(size_t size);
+    size_t mask;
+    std::unique_ptr<std::atomic<Node*>[]> heads;
+  };
+
+  /* a cache line each, so writers of one shard do not slow its neighbours */
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::atomic<Buckets*> buckets{nullptr};
+    size_t size = 0;
+  };
+
+  std::unique_ptr<Shard[]> shards_;
+
+  static uint64_t HashFunction(const std::string& key);
+  Shard& ShardAt(uint64_t hash) const;
+  static std::atomic<Node*>& BucketAt(const Buckets* buckets, uint64_t hash);
+  static const Node* FindNode(const Shard& shard, string key, uint64_t hash);
+  static std::atomic<Node*>* FindLink(Buckets* buckets, string key, uint64_t hash);
+  static void Insert(Shard* shard, const Element* element, uint64_t hash);
+  static bool Erase(Shard* shard, string key, uint64_t hash);
+  static void Grow(Shard* shard);
+  static void DeleteNodes(void* buckets);
+  static void DeleteNodesAndElements(void* buckets);
+  void Release();
+  inline void CopyTable(ConcurrentHashTable const& other);
+};
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_CONCURRENT_HASH_TABLE_H_
@@ -0,0 +1,183 @@
+#include "epoch.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+namespace {
+
+constexpr size_t kSlotsPerBlock = 64;
+constexpr uint64_t kInactive = 0;
+/* retired objects a thread gathers before it tries to free them */
+constexpr size_t kReclaimThreshold = 256;
+
+/* one per reading thread, on its own cache line so pinning stays local */
+struct alignas(64) ReaderSlot {
+  std::atomic<uint64_t> epoch{kInactive};
+  std::atomic<bool> is_used{false};
+};
+
+/* the slots are kept in blocks linked one after another; a block is added
+   when every slot is taken and stays to the end of the program */
+struct SlotBlock {
+  ReaderSlot slots[kSlotsPerBlock];
+  std::atomic<SlotBlock*> next{nullptr};
+};
+
+struct RetiredObject {
+  void* pointer;
+  Epoch::Deleter deleter;
+  uint64_t epoch;
+};
+
+/* what exited threads retired and no reader could be shown to have left */
+struct OrphanList {
+  ~OrphanList() {
+    for (auto& object : objects) object.deleter(object.pointer);
+  }
+
+  std::mutex mutex;
+  std::vector<RetiredObject> objects;
+};
+
+std::atomic<uint64_t> global_epoch{1};
+SlotBlock first_block;
+
+OrphanList& GetOrphanList() {
+  static OrphanList list;
+  return list;
+}
+
+/* a thread keeps its slot until it exits */
+ReaderSlot* AcquireSlot() {
+  for (SlotBlock* block = &first_block;;) {
+    for (auto& slot : block->slots) {
+      bool expected = false;
+      if (!slot.is_used.load(std::memory_order_relaxed) &&
+          slot.is_used.compare_exchange_strong(expected, true)) return &slot;
+    }
+    SlotBlock* next = block->next.load(std::memory_order_acquire);
+    if (!next) {
+      auto added = new SlotBlock();
+      if (block->next.compare_exchange_strong(next, added)) {
+        next = added;
+      } else {
+        delete added;
+      }
+    }
+    block = next;
+  }
+}
+
+/* moves the epoch on and returns the oldest epoch still pinned; the fence
+   pairs with the one in Guard: either the scan sees a reader's pin or that
+   reader sees the unlinking stores */
+uint64_t OldestPinned() {
+  global_epoch.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (SlotBlock* block = &first_block; block; block = block->next.load(std::memory_order_acquire)) {
+    for (auto& slot : block->slots) {
+      uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+      if (epoch != kInactive && epoch < oldest) oldest = epoch;
+    }
+  }
+  return oldest;
+}
+
+/* moves what was retired before oldest from objects to ready */
+void TakeReady(std::vector<RetiredObject>* objects, uint64_t oldest, std::vector<RetiredObject>* ready) {
+  for (size_t i = 0; i < objects->size();) {
+    if ((*objects)[i].epoch < oldest) {
+      ready->push_back((*objects)[i]);
+      (*objects)[i] = objects->back();
+      objects->pop_back();
+    } else {
+      ++i;
+    }
+  }
+}
+
+void Free(const std::vector<RetiredObject>& objects) {
+  for (auto& object : objects) object.deleter(object.pointer);
+}
+
+/* the orphans are taken out under the lock and freed after it */
+size_t ReclaimOrphans(uint64_t oldest) {
+  OrphanList& list = GetOrphanList();
+  std::vector<RetiredObject> ready;
+  size_t left;
+  {
+    std::lock_guard lock(list.mutex);
+    TakeReady(&list.objects, oldest, &ready);
+    left = list.objects.size();
+  }
+  Free(ready);
+  return left;
+}
+
+/* Every thread retires to a list of its own, so writers to different
+   shards or tables do not meet on a lock. What is left when the thread
+   exits goes to the orphans. */
+struct ReaderState {
+  ~ReaderState() {
+    if (slot) slot->is_used.store(false, std::memory_order_release);
+    if (retired.empty()) return;
+    Reclaim();
+    if (retired.empty()) return;
+    OrphanList& list = GetOrphanList();
+    std::lock_guard lock(list.mutex);
+    list.objects.insert(list.objects.end(), retired.begin(), retired.end());
+  }
+
+  /* frees the orphans too, so they do not wait for Epoch::Reclaim;
+     returns the objects of both that are left */
+  size_t Reclaim() {
+    const uint64_t oldest = OldestPinned();
+    std::vector<RetiredObject> ready;
+    TakeReady(&retired, oldest, &ready);
+    Free(ready);
+    /* doubles while pinned readers hold objects back, so a long read does
+       not turn every retire into a full scan */
+    threshold = std::max(kReclaimThreshold, retired.size() * 2);
+    return retired.size() + ReclaimOrphans(oldest);
+  }
+
+  ReaderSlot* slot = nullptr;
+  int depth = 0;
+  std::vector<RetiredObject> retired;
+  size_t threshold = kReclaimThreshold;
+};
+
+thread_local ReaderState reader_state;
+
+}  // namespace
+
+Epoch::Guard::Guard() {
+  if (reader_state.depth++ == 0) {
+    if (!reader_state.slot) reader_state.slot = AcquireSlot();
+    reader_state.slot->epoch.store(global_epoch.load(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+Epoch::Guard::~Guard() {
+  if (--reader_state.depth == 0) {
+    reader_state.slot->epoch.store(kInactive, std::memory_order_release);
+  }
+}
+
+void Epoch::Retire(void* pointer, Deleter deleter) {
+  reader_state.retired.push_back({pointer, deleter, global_epoch.load()});
+  if (reader_state.retired.size() >= reader_state.threshold) reader_state.Reclaim();
+}
+
+size_t Epoch::Reclaim() {
+  return reader_state.Reclaim();
+}
+
+}  // namespace s21
@@ -0,0 +1,46 @@
+#ifndef SRC_CONTAINERS_EPOCH_H_
+#define SRC_CONTAINERS_EPOCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace s21 {
+
+/* Epoch-based reclamation. A reader pins the current epoch for the lifetime
+   of a Guard and may then follow pointers without locks. Writers unlink
+   memory first and Retire it afterwards; it is freed once every reader that
+   was pinned when it got retired has left. Any number of threads may read,
+   the slots they pin in grow in blocks. */
+class Epoch {
+ public:
+  using Deleter = void (*)(void*);
+
+  class Guard {
+   public:
+    Guard();
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    ~Guard();
+  };
+
+  static void Retire(void* pointer, Deleter deleter);
+
+  template <typename T>
+  static void Retire(T* pointer) {
+    Retire(pointer, &Delete<T>);
+  }
+
+  /* frees what the calling thread and the threads that exited retired and
+     no reader can still see, returns the number of those objects left */
+  static size_t Reclaim();
+
+ private:
+  template <typename T>
+  static void Delete(void* pointer) {
+    delete static_cast<T*>(pointer);
+  }
+};
+
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_EPOCH_H_
@@ -1,13 +1,16 @@
 #include "hash_table.h"
 #include <algorithm>
-#include <numeric>
+#include <cstdlib>
+#include <new>
+#include <unordered_set>
+#include "key_hash.h"
 
 namespace s21 {
 
 using data_t = Storage::Element::Data;
 
 HashTable::HashTable() {
-  table_ = std::vector<std::list<Element>>(kSizeOfTable, std::list<Storage::Element>());
+  Init();
 }
 
 HashTable::HashTable(HashTable const& other) {
@@ -15,12 +18,16 @@ HashTable::HashTable(HashTable const& other) {
 }
 
 HashTable::HashTable(HashTable&& other) {
-  std::list<Element> list_temp;
-  for (int i = 0; i <  kSizeOfTable; ++i) {
-    list_temp = table_[i];
-    table_[i] = other.table_[i];
-    other.table_[i] = list_temp;
-  }
+  Init();
+  std::swap(slots_, other.slots_);
+  std::swap(old_slots_, other.old_slots_);
+  std::swap(migrated_, other.migrated_);
+  std::swap(chunks_, other.chunks_);
+  arena_.Swap(&other.arena_);
+  std::swap(free_entries_, other.free_entries_);
+  std::swap(entries_count_, other.entries_count_);
+  std::swap(size_, other.size_);
+  std::swap(has_heap_keys_, other.has_heap_keys_);
 }
 
 HashTable& HashTable::operator=(HashTable const& other) {
@@ -29,134 +36,365 @@ HashTable& HashTable::operator=(HashTable const& other) {
 }
 
 HashTable& HashTable::operator=(HashTable&& other) {
-  CopyTable(other);
+  if (&other != this) {
+    std::swap(slots_, other.slots_);
+    std::swap(old_slots_, other.old_slots_);
+    std::swap(migrated_, other.migrated_);
+    std::swap(chunks_, other.chunks_);
+    arena_.Swap(&other.arena_);
+    std::swap(free_entries_, other.free_entries_);
+    std::swap(entries_count_, other.entries_count_);
+    std::swap(size_, other.size_);
+    std::swap(has_heap_keys_, other.has_heap_keys_);
+  }
   return *this;
 }
 
-HashTable::~HashTable() {}
+HashTable::~HashTable() {
+  DropEntries();
+}
 
 inline void HashTable::CopyTable(HashTable const& other) {
-  table_ = std::vector<std::list<Element>>(kSizeOfTable, std::list<Storage::Element>());
   if (&other != this) {
-    for (int i = 0; i <  kSizeOfTable; ++i) {
-      table_[i] = other.table_[i];
-    }
+    slots_ = other.slots_;
+    old_slots_ = other.old_slots_;
+    migrated_ = other.migrated_;
+    DropEntries();
+    free_entries_.clear();
+    for (uint32_t i = 0; i < other.entries_count_; ++i) EntryAt(AllocateEntry()) = other.EntryAt(i);
+    free_entries_ = other.free_entries_;
+    size_ = other.size_;
+    has_heap_keys_ = other.has_heap_keys_;
   }
 }
 
 bool HashTable::Exists(string key) const {
-  Element element = Get(key);
-  if (element.GetKey() == "") return false;
-  return true;
+  return FindEntry(key) != kNoEntry;
 }
 
 void HashTable::Set(element element) {
-  unsigned long number_of_bucket = HashFunction(element.GetKey());
-  if (std::all_of(table_[number_of_bucket].begin(), table_[number_of_bucket].end(),
-          [element](const Element& elem) {return element.GetKey() != elem.GetKey();})) {
-    table_[number_of_bucket].push_back(element);
+  Set(Element(element));
+}
+
+void HashTable::Set(Element&& element) {
+  Migrate(kMigrationStep);
+  const uint32_t hash = HashFunction(element.GetKey());
+  if (FindPosition(element.GetKey(), hash).slot == kNoSlot) {
+    if ((size_ + 1) * kLoadDenominator > slots_.Size() * kLoadNumerator) Grow();
+    uint32_t index = AllocateEntry();
+    Entry& entry = EntryAt(index);
+    has_heap_keys_ |= !Element::IsInlineKey(element.GetKey());
+    entry.element = std::move(element);
+    entry.is_used = true;
+    InsertSlot(index, hash);
+    ++size_;
   }
 }
 
 Storage::Element HashTable::Get(string key) const {
-  Element* element_ref = GetReference(key);
-  Element result = *element_ref;
-  delete element_ref;
-  return result;
+  uint32_t index = FindEntry(key);
+  if (index == kNoEntry) return Element();
+  return EntryAt(index).element;
+}
+
+bool HashTable::Visit(string key, const Visitor& visitor) const {
+  uint32_t index = FindEntry(key);
+  if (index == kNoEntry) return false;
+  visitor(EntryAt(index).element);
+  return true;
 }
 
 bool HashTable::Del(string key) {
-  unsigned long number_of_bucket = HashFunction(key);
-  for (auto element_of_list : table_[number_of_bucket]) {
-    if (std::any_of(table_[number_of_bucket].begin(), table_[number_of_bucket].end(),
-      [&key](const Element& elem) {
-      return elem.GetKey() == key;
-    })) {
-      table_[number_of_bucket].remove(element_of_list);
-      return true;
+  Migrate(kMigrationStep);
+  Position position = FindPosition(key, HashFunction(key));
+  if (position.slot == kNoSlot) return false;
+  FreeEntry(IndexAt(position));
+  ErasePosition(position);
+  --size_;
+  return true;
+}
+
+bool HashTable::Update(string key, const data_t &data) {
+  Migrate(kMigrationStep);
+  uint32_t index = FindEntry(key);
+  if (index == kNoEntry) return false;
+  Element& element = EntryAt(index).element;
+  element.UpdateData(data);
+  return true;
+}
+
+bool HashTable::Rename(string key, string new_key) {
+  Migrate(kMigrationStep);
+  Position position = FindPosition(key, HashFunction(key));
+  if (position.slot == kNoSlot) return false;
+  if (key == new_key) return true;
+  const uint32_t new_hash = HashFunction(new_key);
+  if (FindPosition(new_key, new_hash).slot != kNoSlot) return false;
+  uint32_t index = IndexAt(position);
+  ErasePosition(position);
+  Entry& entry = EntryAt(index);
+  has_heap_keys_ |= !Element::IsInlineKey(new_key);
+  entry.element.SetKey(new_key);
+  InsertSlot(index, new_hash);
+  return true;
+}
+
+int HashTable::Ttl(string key) const {
+  uint32_t index = FindEntry(key);
+  if (index == kNoEntry) return 0;
+  return EntryAt(index).element.GetLifeTime();
+}
+
+/* records come in the order of their entries, that is insertion order
+   until deleted entries get reused */
+void HashTable::ForEach(const Visitor& visitor) const {
+  for (uint32_t i = 0; i < entries_count_; ++i) {
+    const Entry& entry = EntryAt(i);
+    if (entry.is_used) visitor(entry.element);
+  }
+}
+
+std::vector<Storage::Part> HashTable::Split(size_t parts) const {
+  const size_t count = PartsFor(size_, parts);
+  std::vector<Part> result;
+  for (size_t i = 0; i < count; ++i) {
+    const uint32_t begin = entries_count_ * i / count;
+    const uint32_t end = entries_count_ * (i + 1) / count;
+    result.push_back([this, begin, end](const Visitor& visitor) {
+      for (uint32_t entry = begin; entry < end; ++entry) {
+        if (EntryAt(entry).is_used) visitor(EntryAt(entry).element);
+      }
+    });
+  }
+  return result;
+}
+
+/* entries do not move when the slot array grows, so unlike the other hash
+   engines this one walks its entries in order. New records take freed
+   entries or the end, a walk that reads slower than records come keeps
+   going. */
+std::string HashTable::Scan(const std::string& cursor, string, const ScanVisitor& visitor) const {
+  for (size_t entry = ParseCursor(cursor); entry < entries_count_; ++entry) {
+    if (EntryAt(entry).is_used && !visitor(EntryAt(entry).element)) {
+      return entry + 1 < entries_count_ ? std::to_string(entry + 1) : "0";
     }
   }
-  return false;
+  return "0";
 }
 
-bool HashTable::Update(string key, const data_t &data) {
-  unsigned long number_of_bucket = HashFunction(key);
-  for (auto element_of_list  = table_[number_of_bucket].begin(); element_of_list  !=
-                             table_[number_of_bucket].end(); ++element_of_list ) {
-    if (element_of_list->GetKey() == key) {
-      if (data.surname != "-") element_of_list->SetSurname(data.surname);
-      if (data.name != "-") element_of_list->SetName(data.name);
-      if (data.year_of_birth != "-") element_of_list->SetYearOfBirth(data.year_of_birth);
-      if (data.city != "-") element_of_list->SetCity(data.city);
-      if (data.coins != "-") element_of_list->SetCoins(data.coins);
-      return true;
+/* the upper half of the 64-bit hash: it picks the home slot and is kept in
+   the slot as a fingerprint, so probes reject other keys without loading
+   their records */
+uint32_t HashTable::HashFunction(const std::string& str) const {
+  return static_cast<uint32_t>(KeyHash::Hash(str) >> 32);
+}
+
+void HashTable::Init() {
+  slots_ = Slots(kMinCapacity, kMinShift);
+  old_slots_ = Slots();
+  migrated_ = 0;
+  DropEntries();
+  free_entries_.clear();
+  size_ = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   slots                                    */
+/* -------------------------------------------------------------------------- */
+
+size_t HashTable::FindSlot(const Slots& slots, string key, uint32_t hash) const {
+  const size_t mask = slots.Size() - 1;
+  for (size_t slot = HomeSlot(hash, slots.Shift()); slots[slot].index != kEmptySlot;
+       slot = (slot + 1) & mask) {
+    const Slot& current = slots[slot];
+    if (current.hash == hash && current.index != kMovedSlot &&
+        EntryAt(current.index - 1).element.GetKey() == key) return slot;
+  }
+  return kNoSlot;
+}
+
+HashTable::Position HashTable::FindPosition(string key, uint32_t hash) const {
+  Position position;
+  position.slot = FindSlot(slots_, key, hash);
+  if (position.slot == kNoSlot && IsGrowing()) {
+    position.slot = FindSlot(old_slots_, key, hash);
+    position.is_old = true;
+  }
+  return position;
+}
+
+uint32_t HashTable::IndexAt(Position position) const {
+  return (position.is_old ? old_slots_[position.slot] : slots_[position.slot]).index - 1;
+}
+
+uint32_t HashTable::FindEntry(string key) const {
+  Position position = FindPosition(key, HashFunction(key));
+  return position.slot == kNoSlot ? kNoEntry : IndexAt(position);
+}
+
+void HashTable::InsertSlot(uint32_t index, uint32_t hash) {
+  const size_t mask = slots_.Size() - 1;
+  size_t slot = HomeSlot(hash, slots_.Shift());
+  while (slots_[slot].index != kEmptySlot) slot = (slot + 1) & mask;
+  slots_[slot] = {index + 1, hash};
+}
+
+void HashTable::ErasePosition(Position position) {
+  if (position.is_old) {
+    old_slots_[position.slot].index = kMovedSlot;
+  } else {
+    EraseSlot(position.slot);
+  }
+}
+
+/* backward shift deletion: pull up every following entry of the cluster
+   that may legally occupy the freed slot, so no tombstones are needed */
+void HashTable::EraseSlot(size_t slot) {
+  const size_t mask = slots_.Size() - 1;
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask; slots_[next].index != kEmptySlot; next = (next + 1) & mask) {
+    size_t home = HomeSlot(slots_[next].hash, slots_.Shift());
+    bool is_between = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!is_between) {
+      slots_[hole] = slots_[next];
+      hole = next;
     }
   }
-  return false;
+  slots_[hole] = Slot();
 }
 
-bool HashTable::Rename(string key, string new_key) {
-  unsigned long number_of_bucket = HashFunction(key);
-  for (auto element_of_list : table_[number_of_bucket]) {
-    if (std::any_of(table_[number_of_bucket].begin(), table_[number_of_bucket].end(),
-        [&key](const Element& elem) {
-    return elem.GetKey() == key;
-    })) {
-      Element element_for_rename = element_of_list;
-      table_[number_of_bucket].remove(element_of_list);
-      element_for_rename.SetKey(new_key);
-      Set(element_for_rename);
-      return true;
+/* fibonacci hashing: the top bits of hash * 2^32 / phi pick the slot */
+size_t HashTable::HomeSlot(uint32_t hash, int shift) {
+  return (hash * 0x9E3779B9u) >> shift;
+}
+
+void HashTable::Grow() {
+  if (IsGrowing()) Migrate(old_slots_.Size());
+  old_slots_ = std::move(slots_);
+  slots_ = Slots(old_slots_.Size() * 2, old_slots_.Shift() - 1);
+  migrated_ = 0;
+}
+
+void HashTable::Migrate(size_t count) {
+  if (!IsGrowing()) return;
+  const size_t end = std::min(old_slots_.Size(), migrated_ + count);
+  for (; migrated_ < end; ++migrated_) {
+    Slot& slot = old_slots_[migrated_];
+    if (slot.index != kEmptySlot && slot.index != kMovedSlot) {
+      InsertSlot(slot.index - 1, slot.hash);
+      slot.index = kMovedSlot;
     }
   }
-  return false;
+  if (migrated_ == old_slots_.Size()) {
+    old_slots_ = Slots();
+    migrated_ = 0;
+  }
 }
 
-int HashTable::Ttl(string key) const {
-  Element element_for_research = Get(key);
-  int life_time = 0;
-  if (element_for_research.GetKey() != "") life_time = element_for_research.GetLifeTime();
-  return life_time;
+bool HashTable::IsGrowing() const {
+  return old_slots_.Size() > 0;
 }
 
-HashTable::vector HashTable::Find(const data_t &data) const {
-  HashTable::vector vector_of_key;
-  for (auto element_of_table : table_) {
-    for (auto element_of_list : element_of_table) {
-      if (IsDataSiutable(data, element_of_list.GetData())) vector_of_key.push_back(element_of_list.GetKey());
+HashTable::Statistics HashTable::GetStatistics() const {
+  Statistics statistics;
+  statistics.size = size_;
+  statistics.capacity = slots_.Size() + old_slots_.Size();
+  std::vector<uint32_t> hashes;
+  std::unordered_set<uint64_t> full_hashes;
+  hashes.reserve(size_);
+  for (const Slots* slots : {&slots_, &old_slots_}) {
+    const size_t mask = slots->Size() - 1;
+    for (size_t slot = 0; slot < slots->Size(); ++slot) {
+      const Slot& current = (*slots)[slot];
+      if (current.index == kEmptySlot || current.index == kMovedSlot) continue;
+      size_t distance = (slot - HomeSlot(current.hash, slots->Shift())) & mask;
+      statistics.max_probe = std::max(statistics.max_probe, distance + 1);
+      statistics.average_probe += distance + 1;
+      hashes.push_back(current.hash);
+      uint64_t full_hash = KeyHash::Hash(EntryAt(current.index - 1).element.GetKey());
+      if (!full_hashes.insert(full_hash).second) ++statistics.full_collisions;
     }
   }
-  return vector_of_key;
+  if (size_ > 0) statistics.average_probe /= size_;
+  std::sort(hashes.begin(), hashes.end());
+  for (size_t i = 1; i < hashes.size(); ++i) {
+    if (hashes[i] == hashes[i - 1]) ++statistics.fingerprint_collisions;
+  }
+  return statistics;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Slots                                    */
+/* -------------------------------------------------------------------------- */
+
+HashTable::Slots::Slots(size_t size, int shift)
+  : data_(static_cast<Slot*>(std::calloc(size, sizeof(Slot)))), size_(size), shift_(shift) {
+  if (!data_ && size_ > 0) throw std::bad_alloc();
+}
+
+HashTable::Slots::Slots(const Slots& other)
+  : Slots(other.size_, other.shift_) {
+  std::copy(other.data_, other.data_ + size_, data_);
+}
+
+HashTable::Slots::Slots(Slots&& other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(shift_, other.shift_);
 }
 
-unsigned long HashTable::HashFunction(const std::string& str) const {
-  unsigned long hash = std::accumulate(str.begin(), str.end(), 5381,
-                       [](unsigned long currentHash, const char& c) {
-                            return currentHash * 128 + currentHash + c;
-                        });
-  return hash % kSizeOfTable;
+HashTable::Slots& HashTable::Slots::operator=(Slots other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(shift_, other.shift_);
+  return *this;
+}
+
+HashTable::Slots::~Slots() {
+  std::free(data_);
 }
 
-std::vector<HashTable::Element> HashTable::AllElements() const  {
-  std::vector<Element> vector_of_elements;
-  for (auto element_of_table : table_) {
-     std::transform(element_of_table.begin(), element_of_table.end(), std::back_inserter(vector_of_elements),
-                                            [](const Element& elem) {return elem;});
+/* -------------------------------------------------------------------------- */
+/*                                  entries                                   */
+/* -------------------------------------------------------------------------- */
+
+uint32_t HashTable::AllocateEntry() {
+  if (!free_entries_.empty()) {
+    uint32_t index = free_entries_.back();
+    free_entries_.pop_back();
+    return index;
+  }
+  if (entries_count_ == chunks_.size() * kChunkSize) {
+    chunks_.push_back(static_cast<Entry*>(arena_.Allocate(kChunkSize * sizeof(Entry))));
   }
-  return vector_of_elements;
+  new (&EntryAt(entries_count_)) Entry();
+  return entries_count_++;
 }
 
-HashTable::Element* HashTable::GetReference(string key) const {
-  unsigned long number_of_bucket = HashFunction(key);
-  Element* element = new Element();
-  for (auto element_of_list : table_[number_of_bucket]) {
-    if (element_of_list.GetKey() == key)
-      *element = element_of_list;
+void HashTable::FreeEntry(uint32_t index) {
+  Entry& entry = EntryAt(index);
+  entry.element = Element();
+  entry.is_used = false;
+  free_entries_.push_back(index);
+}
+
+/* entries without heap keys are not destroyed one by one, the arena
+   blocks are freed under them */
+void HashTable::DropEntries() {
+  if (has_heap_keys_) {
+    for (uint32_t i = 0; i < entries_count_; ++i) EntryAt(i).~Entry();
   }
-  return element;
+  chunks_.clear();
+  arena_.Release();
+  entries_count_ = 0;
+  has_heap_keys_ = false;
 }
 
-void HashTable::Init() {
-  table_ = std::vector<std::list<Element>>(kSizeOfTable, std::list<Storage::Element>());
+HashTable::Entry& HashTable::EntryAt(uint32_t index) {
+  return chunks_[index / kChunkSize][index % kChunkSize];
+}
+
+const HashTable::Entry& HashTable::EntryAt(uint32_t index) const {
+  return chunks_[index / kChunkSize][index % kChunkSize];
 }
 }  // namespace s21
@@ -1,15 +1,34 @@
 #ifndef SRC_CONTAINERS_HASH_TABLE_H_
 #define SRC_CONTAINERS_HASH_TABLE_H_
 
-#include <list>
+#include <cstdint>
+#include <vector>
 #include "../storage.h"
+#include "arena.h"
 
 namespace s21 {
 
+/* Open addressing with linear probing. Slots keep the index of the record
+   and a 32-bit fingerprint of its key, the records themselves live in
+   fixed-size chunks and never move,
+   so growing the table rebuilds the slot array only. The rebuild is spread
+   over the following modifications: while the old slot array is being
+   drained every lookup checks both arrays. Chunks come from the arena of
+   the table, Init releases them at once when no key needed heap memory. */
 class HashTable : public Storage {
  public:
   using data_t = Storage::Element::Data;
 
+  /* probe lengths are counted in slots, 1 for a key in its home slot */
+  struct Statistics {
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t max_probe = 0;
+    double average_probe = 0;
+    size_t full_collisions = 0;
+    size_t fingerprint_collisions = 0;
+  };
+
  public:
   HashTable();
   HashTable(HashTable const&);
@@ -18,23 +37,109 @@ class HashTable : public Storage {
   HashTable& operator=(HashTable&&);
   ~HashTable();
   void Set(element element) override;
+  void Set(Element&& element) override;
   Element Get(string key) const override;
+  bool Visit(string key, const Visitor& visitor) const override;
+  void ForEach(const Visitor& visitor) const override;
+  /* runs of entries */
+  std::vector<Part> Split(size_t parts) const override;
+  /* the cursor is the next entry */
+  std::string Scan(const std::string& cursor, string prefix, const ScanVisitor& visitor) const override;
   bool Exists(string key) const override;
   bool Del(string key) override;
   bool Update(string key, const data_t& data) override;
   bool Rename(string key, string new_key) override;
   int Ttl(string key) const override;
-  vector Find(const data_t& data) const override;
-  std::vector<Element> AllElements() const override;
   void Init() override;
+  Statistics GetStatistics() const;
 
  private:
-  static const int kSizeOfTable = 100;
-  std::vector<std::list<Element>> table_;
+  struct Entry {
+    Element element;
+    bool is_used = false;
+  };
+
+  /* index is entry index + 1, hash is the key fingerprint */
+  struct Slot {
+    uint32_t index = 0;
+    uint32_t hash = 0;
+  };
+
+  /* a zeroed slot array is an empty one */
+  static constexpr uint32_t kEmptySlot = 0;
+  /* marks a slot of the old array whose entry was moved or deleted, probing
+     continues past it so the rest of the cluster stays reachable */
+  static constexpr uint32_t kMovedSlot = 0xffffffff;
+  static constexpr uint32_t kNoEntry = 0xffffffff;
+  static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr int kMinShift = 32 - 4;
+  static constexpr uint32_t kChunkSize = 1024;
+  /* table grows when size_ * kLoadDenominator > capacity * kLoadNumerator */
+  static constexpr size_t kLoadNumerator = 1;
+  static constexpr size_t kLoadDenominator = 2;
+  /* old slots moved per modification: the old array (capacity C, C / 2
+     entries) is drained long before the new one (2C) fills up to C */
+  static constexpr size_t kMigrationStep = 8;
+
+  /* slot array taken from calloc: big blocks come from the OS already
+     zeroed, so doubling the table does not fault in every page up front,
+     the pages are paid for by the probes that first touch them */
+  class Slots {
+   public:
+    Slots() = default;
+    Slots(size_t size, int shift);
+    Slots(const Slots& other);
+    Slots(Slots&& other);
+    Slots& operator=(Slots other);
+    ~Slots();
+
+    Slot& operator[](size_t slot) { return data_[slot]; }
+    const Slot& operator[](size_t slot) const { return data_[slot]; }
+    size_t Size() const { return size_; }
+    int Shift() const { return shift_; }
+
+   private:
+    Slot* data_ = nullptr;
+    size_t size_ = 0;
+    int shift_ = kMinShift;
+  };
+
+  /* location of a key: slot number in the new or in the old array */
+  struct Position {
+    size_t slot = kNoSlot;
+    bool is_old = false;
+  };
+
+  Slots slots_;
+  Slots old_slots_;
+  size_t migrated_ = 0;
+  Arena arena_;
+  /* entries below entries_count_ are constructed */
+  std::vector<Entry*> chunks_;
+  std::vector<uint32_t> free_entries_;
+  uint32_t entries_count_ = 0;
+  size_t size_ = 0;
+  /* set once a key longer than the inline string buffer was stored */
+  bool has_heap_keys_ = false;
 
-  unsigned long HashFunction(const std::string& str) const;
-  Element* GetReference(string key) const;
-  Element& GetAdress(string key);
+  uint32_t HashFunction(const std::string& str) const;
+  static size_t HomeSlot(uint32_t hash, int shift);
+  size_t FindSlot(const Slots& slots, string key, uint32_t hash) const;
+  Position FindPosition(string key, uint32_t hash) const;
+  uint32_t IndexAt(Position position) const;
+  uint32_t FindEntry(string key) const;
+  void InsertSlot(uint32_t index, uint32_t hash);
+  void ErasePosition(Position position);
+  void EraseSlot(size_t slot);
+  void Grow();
+  void Migrate(size_t count);
+  bool IsGrowing() const;
+  uint32_t AllocateEntry();
+  void FreeEntry(uint32_t index);
+  void DropEntries();
+  Entry& EntryAt(uint32_t index);
+  const Entry& EntryAt(uint32_t index) const;
   inline void CopyTable(HashTable const& other);
 };
 }  // namespace s21
@@ -0,0 +1,85 @@
+#ifndef SRC_CONTAINERS_KEY_HASH_H_
+#define SRC_CONTAINERS_KEY_HASH_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace s21 {
+
+/* 64-bit string hash in the spirit of wyhash: the key is read eight bytes
+   at a time and every pair of words is folded by one 64x64->128 multiply,
+   short keys are covered by two overlapping reads without a byte loop */
+class KeyHash {
+ public:
+  static uint64_t Hash(const std::string& key) {
+    return Hash(key.data(), key.size());
+  }
+
+  static uint64_t Hash(const char* data, size_t length) {
+    uint64_t seed = kSecret0 ^ Mix(kSeed ^ kSecret0, kSecret1);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (length <= 16) {
+      if (length >= 4) {
+        const size_t middle = (length >> 3) << 2;
+        a = (Read4(data) << 32) | Read4(data + middle);
+        b = (Read4(data + length - 4) << 32) | Read4(data + length - 4 - middle);
+      } else if (length > 0) {
+        a = Read3(data, length);
+      }
+    } else {
+      size_t rest = length;
+      const char* position = data;
+      while (rest > 16) {
+        seed = Mix(Read8(position) ^ kSecret1, Read8(position + 8) ^ seed);
+        position += 16;
+        rest -= 16;
+      }
+      a = Read8(position + rest - 16);
+      b = Read8(position + rest - 8);
+    }
+    a ^= kSecret1;
+    b ^= seed;
+    Multiply(&a, &b);
+    return Mix(a ^ kSecret0 ^ length, b ^ kSecret1);
+  }
+
+ private:
+  static constexpr uint64_t kSeed = 0x5381;
+  static constexpr uint64_t kSecret0 = 0xa0761d6478bd642full;
+  static constexpr uint64_t kSecret1 = 0xe7037ed1a0b428dbull;
+
+  static void Multiply(uint64_t* a, uint64_t* b) {
+    __uint128_t product = static_cast<__uint128_t>(*a) * *b;
+    *a = static_cast<uint64_t>(product);
+    *b = static_cast<uint64_t>(product >> 64);
+  }
+
+  static uint64_t Mix(uint64_t a, uint64_t b) {
+    Multiply(&a, &b);
+    return a ^ b;
+  }
+
+  static uint64_t Read8(const char* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+  }
+
+  static uint64_t Read4(const char* data) {
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+  }
+
+  static uint64_t Read3(const char* data, size_t length) {
+    return (static_cast<uint64_t>(static_cast<unsigned char>(data[0])) << 16)
+         | (static_cast<uint64_t>(static_cast<unsigned char>(data[length >> 1])) << 8)
+         | static_cast<unsigned char>(data[length - 1]);
+  }
+};
+
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_KEY_HASH_H_
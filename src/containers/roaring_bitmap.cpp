@@ -0,0 +1,199 @@
+#include "roaring_bitmap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace s21 {
+
+void RoaringBitmap::Add(uint32_t value) {
+  const uint16_t high = value >> 16;
+  const uint16_t low = value & 0xFFFF;
+  auto it = Find(high);
+  if (it == containers_.end() || it->high != high) {
+    it = containers_.insert(it, Container());
+    it->high = high;
+  }
+  if (it->IsBitset()) {
+    uint64_t& word = it->bitset[low / 64];
+    const uint64_t bit = uint64_t{1} << (low % 64);
+    if (!(word & bit)) ++it->cardinality;
+    word |= bit;
+    return;
+  }
+  auto position = std::lower_bound(it->array.begin(), it->array.end(), low);
+  if (position != it->array.end() && *position == low) return;
+  it->array.insert(position, low);
+  ++it->cardinality;
+  if (it->cardinality > kArrayLimit) it->ToBitset();
+}
+
+void RoaringBitmap::Remove(uint32_t value) {
+  const uint16_t high = value >> 16;
+  const uint16_t low = value & 0xFFFF;
+  auto it = Find(high);
+  if (it == containers_.end() || it->high != high) return;
+  if (it->IsBitset()) {
+    uint64_t& word = it->bitset[low / 64];
+    const uint64_t bit = uint64_t{1} << (low % 64);
+    if (!(word & bit)) return;
+    word &= ~bit;
+    --it->cardinality;
+    it->Shrink();
+  } else {
+    auto position = std::lower_bound(it->array.begin(), it->array.end(), low);
+    if (position == it->array.end() || *position != low) return;
+    it->array.erase(position);
+    --it->cardinality;
+    /* halving keeps the removals amortized O(1) on top of the erase */
+    if (it->array.capacity() > 2 * it->array.size() + kMinCapacity) it->array.shrink_to_fit();
+  }
+  if (it->cardinality != 0) return;
+  containers_.erase(it);
+  if (containers_.capacity() > 2 * containers_.size() + kMinCapacity) containers_.shrink_to_fit();
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const {
+  const uint16_t high = value >> 16;
+  auto it = Find(high);
+  return it != containers_.end() && it->high == high && it->Contains(value & 0xFFFF);
+}
+
+bool RoaringBitmap::Empty() const {
+  return containers_.empty();
+}
+
+size_t RoaringBitmap::Cardinality() const {
+  size_t cardinality = 0;
+  for (const Container& container : containers_) cardinality += container.cardinality;
+  return cardinality;
+}
+
+void RoaringBitmap::And(const RoaringBitmap& other) {
+  auto other_it = other.containers_.begin();
+  auto out = containers_.begin();
+  for (auto it = containers_.begin(); it != containers_.end(); ++it) {
+    while (other_it != other.containers_.end() && other_it->high < it->high) ++other_it;
+    if (other_it == other.containers_.end()) break;
+    if (other_it->high != it->high) continue;
+    And(&*it, *other_it);
+    if (it->cardinality == 0) continue;
+    if (out != it) *out = std::move(*it);
+    ++out;
+  }
+  containers_.erase(out, containers_.end());
+}
+
+void RoaringBitmap::Or(const RoaringBitmap& other) {
+  std::vector<Container> result;
+  result.reserve(containers_.size() + other.containers_.size());
+  auto it = containers_.begin();
+  auto other_it = other.containers_.begin();
+  while (it != containers_.end() || other_it != other.containers_.end()) {
+    if (other_it == other.containers_.end() || (it != containers_.end() && it->high < other_it->high)) {
+      result.push_back(std::move(*it++));
+    } else if (it == containers_.end() || other_it->high < it->high) {
+      result.push_back(*other_it++);
+    } else {
+      Or(&*it, *other_it++);
+      result.push_back(std::move(*it++));
+    }
+  }
+  containers_ = std::move(result);
+}
+
+size_t RoaringBitmap::Bytes() const {
+  size_t bytes = containers_.capacity() * sizeof(Container);
+  for (const Container& container : containers_) {
+    bytes += container.array.capacity() * sizeof(uint16_t) + container.bitset.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+bool RoaringBitmap::Container::Contains(uint16_t low) const {
+  if (IsBitset()) return bitset[low / 64] & (uint64_t{1} << (low % 64));
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RoaringBitmap::Container::ToBitset() {
+  bitset.assign(kBitsetWords, 0);
+  for (uint16_t low : array) bitset[low / 64] |= uint64_t{1} << (low % 64);
+  std::vector<uint16_t>().swap(array);
+}
+
+void RoaringBitmap::Container::ToArray() {
+  array.reserve(cardinality);
+  for (size_t i = 0; i < kBitsetWords; ++i) {
+    for (uint64_t word = bitset[i]; word; word &= word - 1) {
+      array.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+    }
+  }
+  std::vector<uint64_t>().swap(bitset);
+}
+
+/* half the limit, so a container on the border does not change its kind on
+   every Add and Remove */
+void RoaringBitmap::Container::Shrink() {
+  if (IsBitset() && cardinality <= kArrayLimit / 2) ToArray();
+}
+
+std::vector<RoaringBitmap::Container>::iterator RoaringBitmap::Find(uint16_t high) {
+  return std::lower_bound(containers_.begin(), containers_.end(), high,
+                          [](const Container& container, uint16_t value) { return container.high < value; });
+}
+
+std::vector<RoaringBitmap::Container>::const_iterator RoaringBitmap::Find(uint16_t high) const {
+  return std::lower_bound(containers_.begin(), containers_.end(), high,
+                          [](const Container& container, uint16_t value) { return container.high < value; });
+}
+
+void RoaringBitmap::And(Container* container, const Container& other) {
+  if (container->IsBitset() && other.IsBitset()) {
+    container->cardinality = 0;
+    for (size_t i = 0; i < kBitsetWords; ++i) {
+      container->bitset[i] &= other.bitset[i];
+      container->cardinality += __builtin_popcountll(container->bitset[i]);
+    }
+    container->Shrink();
+    return;
+  }
+  if (container->IsBitset()) {
+    std::vector<uint16_t> array;
+    for (uint16_t low : other.array) {
+      if (container->Contains(low)) array.push_back(low);
+    }
+    std::vector<uint64_t>().swap(container->bitset);
+    container->array = std::move(array);
+  } else if (other.IsBitset()) {
+    auto end = std::remove_if(container->array.begin(), container->array.end(),
+                              [&other](uint16_t low) { return !other.Contains(low); });
+    container->array.erase(end, container->array.end());
+  } else {
+    std::vector<uint16_t> array;
+    std::set_intersection(container->array.begin(), container->array.end(), other.array.begin(),
+                          other.array.end(), std::back_inserter(array));
+    container->array = std::move(array);
+  }
+  container->cardinality = container->array.size();
+}
+
+void RoaringBitmap::Or(Container* container, const Container& other) {
+  if (!container->IsBitset() && !other.IsBitset()) {
+    std::vector<uint16_t> array;
+    array.reserve(container->array.size() + other.array.size());
+    std::set_union(container->array.begin(), container->array.end(), other.array.begin(), other.array.end(),
+                   std::back_inserter(array));
+    container->array = std::move(array);
+    container->cardinality = container->array.size();
+    if (container->cardinality > kArrayLimit) container->ToBitset();
+    return;
+  }
+  if (!container->IsBitset()) container->ToBitset();
+  if (other.IsBitset()) {
+    for (size_t i = 0; i < kBitsetWords; ++i) container->bitset[i] |= other.bitset[i];
+  } else {
+    for (uint16_t low : other.array) container->bitset[low / 64] |= uint64_t{1} << (low % 64);
+  }
+  container->cardinality = 0;
+  for (uint64_t word : container->bitset) container->cardinality += __builtin_popcountll(word);
+}
+
+}  // namespace s21
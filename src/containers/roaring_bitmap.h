@@ -0,0 +1,75 @@
+#ifndef SRC_CONTAINERS_ROARING_BITMAP_H_
+#define SRC_CONTAINERS_ROARING_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace s21 {
+
+/* A set of 32-bit numbers in the Roaring layout: the numbers are split by
+   their upper 16 bits into containers, a container with few numbers keeps
+   the lower halves in a sorted array, a full one keeps a bitset of 8 KiB.
+   Set operations go container by container, so AND and OR of bitsets are
+   word operations. Run containers are not used. */
+class RoaringBitmap {
+ public:
+  void Add(uint32_t value);
+  void Remove(uint32_t value);
+  bool Contains(uint32_t value) const;
+  bool Empty() const;
+  size_t Cardinality() const;
+  void And(const RoaringBitmap& other);
+  void Or(const RoaringBitmap& other);
+  /* heap bytes of the containers */
+  size_t Bytes() const;
+
+  /* in increasing order */
+  template <typename Visitor>
+  void ForEach(Visitor visitor) const {
+    for (const Container& container : containers_) {
+      const uint32_t high = static_cast<uint32_t>(container.high) << 16;
+      if (!container.IsBitset()) {
+        for (uint16_t low : container.array) visitor(high | low);
+        continue;
+      }
+      for (size_t i = 0; i < kBitsetWords; ++i) {
+        for (uint64_t word = container.bitset[i]; word; word &= word - 1) {
+          visitor(high | static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+        }
+      }
+    }
+  }
+
+ private:
+  /* an array of this many lower halves takes as much as a bitset */
+  static constexpr size_t kArrayLimit = 4096;
+  static constexpr size_t kBitsetWords = 1024;
+  /* vectors shorter than this are not shrunk */
+  static constexpr size_t kMinCapacity = 16;
+
+  struct Container {
+    uint16_t high = 0;
+    uint32_t cardinality = 0;
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> bitset;
+
+    bool IsBitset() const { return !bitset.empty(); }
+    bool Contains(uint16_t low) const;
+    void ToBitset();
+    void ToArray();
+    /* a bitset small enough after AND or Remove becomes an array again */
+    void Shrink();
+  };
+
+  std::vector<Container> containers_;
+
+  std::vector<Container>::iterator Find(uint16_t high);
+  std::vector<Container>::const_iterator Find(uint16_t high) const;
+  static void And(Container* container, const Container& other);
+  static void Or(Container* container, const Container& other);
+};
+
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_ROARING_BITMAP_H_
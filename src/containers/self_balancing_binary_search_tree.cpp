@@ -15,6 +15,13 @@ SelfBalancingBinarySearchTree::Element SelfBalancingBinarySearchTree::Get(string
   return SelfBalancingBinarySearchTree::Element("", {});
 }
 
+bool SelfBalancingBinarySearchTree::Visit(string key, const Visitor& visitor) const {
+  Node* node = FindNode(key);
+  if (!node) return false;
+  visitor(node->key_);
+  return true;
+}
+
 bool SelfBalancingBinarySearchTree::Exists(string key) const {
   if (FindNode(key)) return true;
   return false;
@@ -32,26 +39,30 @@ bool SelfBalancingBinarySearchTree::Del(string key) {
 bool SelfBalancingBinarySearchTree::Update(string key, const Element::Data& data) {
   Node* node = FindNode(key);
   if (node) {
-    if (data.surname != "-") node->key_.SetSurname(data.surname);
-    if (data.name != "-") node->key_.SetName(data.name);
-    if (data.year_of_birth != "-") node->key_.SetYearOfBirth(data.year_of_birth);
-    if (data.city != "-") node->key_.SetCity(data.city);
-    if (data.coins != "-") node->key_.SetCoins(data.coins);
+    node->key_.UpdateData(data);
     return true;
   }
   return false;
 }
 
+/* a key that stays between the same neighbours is changed in the node,
+   otherwise the record data is moved out, the node removed and the record
+   linked in again */
 bool SelfBalancingBinarySearchTree::Rename(string key, string new_key) {
   Node* node = FindNode(key);
-  if (node) {
-    Element element = node->key_;
-    element.SetKey(new_key);
-    Remove(key);
-    Set(element);
+  if (!node) return false;
+  if (key == new_key) return true;
+  if (FindNode(new_key)) return false;
+  if (KeepsOrder(node, new_key)) {
+    has_heap_keys_ |= !Element::IsInlineKey(new_key);
+    node->key_.SetKey(new_key);
     return true;
   }
-  return false;
+  Element element(new_key, {});
+  *element = std::move(*node->key_);
+  Remove(key);
+  Insert(std::move(element));
+  return true;
 }
 
 int SelfBalancingBinarySearchTree::Ttl(string key) const {
@@ -62,31 +73,93 @@ int SelfBalancingBinarySearchTree::Ttl(string key) const {
   return 0;
 }
 
-std::vector<std::string> SelfBalancingBinarySearchTree::Find(const Element::Data& data) const {
-  std::vector<std::string> vector_of_key;
-  auto nodes = GetAllNodes();
-  for (auto node : nodes) {
-    if (IsDataSiutable(data, node->key_.GetData())) {
-      vector_of_key.push_back(node->key_.GetKey());
-    }
+void SelfBalancingBinarySearchTree::ForEach(const Visitor& visitor) const {
+  VisitNode(root_, visitor);
+}
+
+std::string SelfBalancingBinarySearchTree::Scan(const std::string& cursor, string prefix,
+                                                const ScanVisitor& visitor) const {
+  bool is_after;
+  const std::string from = ScanFrom(cursor, prefix, &is_after);
+  for (const Node* node = LowerBound(from, is_after); node && HasPrefix(node->key_.GetKey(), prefix);
+       node = NextNode(node)) {
+    if (!visitor(node->key_)) return OrderedCursor(node->key_.GetKey());
   }
-  return vector_of_key;
+  return "0";
 }
 
-void SelfBalancingBinarySearchTree::Init() {
-  Clear(root_);
-  root_ = nullptr;
+const SelfBalancingBinarySearchTree::Node* SelfBalancingBinarySearchTree::LowerBound(const std::string& key,
+                                                                                     bool is_after) const {
+  const Node* bound = nullptr;
+  for (const Node* node = root_; node;) {
+    const std::string& current = node->key_.GetKey();
+    if (current > key || (!is_after && current == key)) {
+      bound = node;
+      node = node->left_;
+    } else {
+      node = node->right_;
+    }
+  }
+  return bound;
 }
 
+/* the leftmost node of the right subtree, or the first ancestor reached
+   from its left */
+const SelfBalancingBinarySearchTree::Node* SelfBalancingBinarySearchTree::NextNode(const Node* node) {
+  if (node->right_) {
+    node = node->right_;
+    while (node->left_) node = node->left_;
+    return node;
+  }
+  while (node->parent_ && node == node->parent_->right_) node = node->parent_;
+  return node->parent_;
+}
 
-std::vector<SelfBalancingBinarySearchTree::Element> SelfBalancingBinarySearchTree::AllElements() const {
-  std::vector<SelfBalancingBinarySearchTree::Element> result;
-  auto nodes = GetAllNodes();
-  std::transform(nodes.begin(), nodes.end(), std::back_inserter(result),
-                                            [](Node* node) {return node->key_;});
+/* A subtree gives way to its root and its two subtrees level by level. No
+   path of an AVL tree is much shorter than the others, so the leftmost one
+   tells how many levels may go before the subtrees get too small. */
+std::vector<Storage::Part> SelfBalancingBinarySearchTree::Split(size_t parts) const {
+  struct Piece {
+    const Node* node;
+    bool is_subtree;
+  };
+  size_t depth = 0;
+  for (const Node* node = root_; node; node = node->left_) ++depth;
+  std::vector<Piece> pieces = {{root_, true}};
+  for (size_t level = 0; pieces.size() < parts && level + kMinPartDepth < depth; ++level) {
+    std::vector<Piece> next;
+    for (const Piece& piece : pieces) {
+      if (!piece.is_subtree) {
+        next.push_back(piece);
+        continue;
+      }
+      next.push_back({piece.node, false});
+      if (piece.node->left_) next.push_back({piece.node->left_, true});
+      if (piece.node->right_) next.push_back({piece.node->right_, true});
+    }
+    pieces.swap(next);
+  }
+  std::vector<Part> result;
+  for (const Piece& piece : pieces) {
+    result.push_back([this, piece](const Visitor& visitor) {
+      if (piece.is_subtree) {
+        VisitNode(piece.node, visitor);
+      } else {
+        visitor(piece.node->key_);
+      }
+    });
+  }
   return result;
 }
 
+void SelfBalancingBinarySearchTree::Init() {
+  if (has_heap_keys_) Clear(root_);
+  arena_.Release();
+  root_ = nullptr;
+  has_heap_keys_ = false;
+}
+
+
 std::vector<SelfBalancingBinarySearchTree::Node*> SelfBalancingBinarySearchTree::GetAllNodes() const {
   std::vector<Node*> result;
   GetElement(root_, &result);
@@ -102,6 +175,15 @@ void SelfBalancingBinarySearchTree::GetElement(SelfBalancingBinarySearchTree::No
   }
 }
 
+/* same order as GetAllNodes: the node, then its left and right subtrees */
+void SelfBalancingBinarySearchTree::VisitNode(const Node* node, const Visitor& visitor) const {
+  if (node) {
+    visitor(node->key_);
+    VisitNode(node->left_, visitor);
+    VisitNode(node->right_, visitor);
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                 class Tree                                 */
 /* -------------------------------------------------------------------------- */
@@ -114,6 +196,8 @@ SelfBalancingBinarySearchTree::SelfBalancingBinarySearchTree(const SelfBalancing
 
 SelfBalancingBinarySearchTree::SelfBalancingBinarySearchTree(SelfBalancingBinarySearchTree&& other) {
   std::swap(root_, other.root_);
+  arena_.Swap(&other.arena_);
+  std::swap(has_heap_keys_, other.has_heap_keys_);
 }
 
 SelfBalancingBinarySearchTree&
@@ -130,16 +214,12 @@ SelfBalancingBinarySearchTree::operator=(const SelfBalancingBinarySearchTree&& o
 
 inline void SelfBalancingBinarySearchTree::CopyTree(const SelfBalancingBinarySearchTree& other) {
   if (&other != this) {
-    for (auto element : other.GetAllNodes()) {
-      Set(element->key_);
-    }
+    other.ForEach([this](const Element& element) { Set(element); });
   }
 }
 
 SelfBalancingBinarySearchTree::~SelfBalancingBinarySearchTree() {
-  if (root_) {
-    Clear(root_);
-  }
+  if (has_heap_keys_) Clear(root_);
 }
 
 void SelfBalancingBinarySearchTree::Clear(Node* node) {
@@ -150,37 +230,95 @@ void SelfBalancingBinarySearchTree::Clear(Node* node) {
     if (node->left_) {
       Clear(node->left_);
     }
-    delete node;
+    arena_.Delete(node);
   }
 }
 
 void SelfBalancingBinarySearchTree::Set(element key) {
-  if (!Exists(key.GetKey())) {
-    is_remove_ = false;
-    Node* current_node = root_;
-    Node* previous_node = nullptr;
-    bool is_left = true;
-    while (current_node) {
-      previous_node = current_node;
-      if (key.GetKey() > current_node->key_.GetKey()) {
-        current_node = current_node->right_;
-        is_left = false;
-      } else {
-        current_node = current_node->left_;
-        is_left = true;
-      }
-    }
+  Set(Element(key));
+}
+
+void SelfBalancingBinarySearchTree::Set(Element&& key) {
+  if (!Exists(key.GetKey())) Insert(std::move(key));
+}
 
-    current_node = new Node(key, previous_node);
-    is_balanced_ = false;
-    if (is_left && root_) {
-      previous_node->left_ = current_node;
-    } else if (root_) {
-      previous_node->right_ = current_node;
+/* the key must not be in the tree yet */
+void SelfBalancingBinarySearchTree::Insert(Element&& key) {
+  is_remove_ = false;
+  Node* current_node = root_;
+  Node* previous_node = nullptr;
+  bool is_left = true;
+  while (current_node) {
+    previous_node = current_node;
+    if (key.GetKey() > current_node->key_.GetKey()) {
+      current_node = current_node->right_;
+      is_left = false;
+    } else {
+      current_node = current_node->left_;
+      is_left = true;
     }
-    if (!root_) root_ = current_node;
-    RebalanceAfterInsert(current_node);
   }
+
+  has_heap_keys_ |= !Element::IsInlineKey(key.GetKey());
+  current_node = arena_.New<Node>(std::move(key), previous_node);
+  is_balanced_ = false;
+  if (is_left && root_) {
+    previous_node->left_ = current_node;
+  } else if (root_) {
+    previous_node->right_ = current_node;
+  }
+  if (!root_) root_ = current_node;
+  RebalanceAfterInsert(current_node);
+}
+
+bool SelfBalancingBinarySearchTree::IsBulkLoaded() const {
+  return true;
+}
+
+void SelfBalancingBinarySearchTree::Load(std::vector<Element>* elements) {
+  SortByKey(elements);
+  int height;
+  root_ = BuildBalanced(elements->data(), elements->size(), nullptr, &height);
+}
+
+/* the middle record is the root, the halves on either side its subtrees;
+   the nodes come from the arena in the preorder ForEach walks them in */
+SelfBalancingBinarySearchTree::Node* SelfBalancingBinarySearchTree::BuildBalanced(Element* elements, size_t count,
+                                                                                  Node* parent, int* height) {
+  if (count == 0) {
+    *height = 0;
+    return nullptr;
+  }
+  const size_t middle = count / 2;
+  has_heap_keys_ |= !Element::IsInlineKey(elements[middle].GetKey());
+  Node* node = arena_.New<Node>(std::move(elements[middle]), parent);
+  int left_height;
+  int right_height;
+  node->left_ = BuildBalanced(elements, middle, node, &left_height);
+  node->right_ = BuildBalanced(elements + middle + 1, count - middle - 1, node, &right_height);
+  node->balance_ = left_height - right_height;
+  *height = std::max(left_height, right_height) + 1;
+  return node;
+}
+
+/* true when the search for new_key takes the same path as for the key of
+   the node and new_key sits between the subtrees of the node */
+bool SelfBalancingBinarySearchTree::KeepsOrder(Node* node, string new_key) {
+  string key = node->key_.GetKey();
+  for (const Node* current = root_; current != node;) {
+    bool is_right = key > current->key_.GetKey();
+    if (is_right != (new_key > current->key_.GetKey())) return false;
+    current = is_right ? current->right_ : current->left_;
+  }
+  if (node->left_ && FindMax(node)->key_.GetKey() >= new_key) return false;
+  if (node->right_ && FindMin(node)->key_.GetKey() <= new_key) return false;
+  return true;
+}
+
+/* moves the data and copies only the key */
+void SelfBalancingBinarySearchTree::MoveElement(Element* to, Element* from) {
+  to->SetKey(from->GetKey());
+  **to = std::move(**from);
 }
 
 void SelfBalancingBinarySearchTree::RebalanceAfterInsert(Node* node) {
@@ -402,7 +540,7 @@ SelfBalancingBinarySearchTree::Node* SelfBalancingBinarySearchTree::FindNode(con
 void SelfBalancingBinarySearchTree::RemoveWhenNoChild(Node* removable_node) {
   Node* parent = removable_node->parent_;
   if (!parent && removable_node == root_) {
-    delete removable_node;
+    arena_.Delete(removable_node);
     root_ = nullptr;
   } else {
     RemoveNode(removable_node);
@@ -414,14 +552,16 @@ void SelfBalancingBinarySearchTree::RemoveWhenTwoChildren(Node* removable_node)
   int balance = removable_node->balance_;
   if (balance == 1 || balance == 0) {
     auto *replacement_node = FindMax(removable_node);
-    Element temp_key = replacement_node->key_;
+    Element temp_key;
+    MoveElement(&temp_key, &replacement_node->key_);
     Remove(temp_key.GetKey());
-    removable_node->key_ = temp_key;
+    MoveElement(&removable_node->key_, &temp_key);
   } else if (balance == -1) {
     auto *replacement_node = FindMin(removable_node);
-    Element temp_key = replacement_node->key_;
+    Element temp_key;
+    MoveElement(&temp_key, &replacement_node->key_);
     Remove(temp_key.GetKey());
-    removable_node->key_ = temp_key;
+    MoveElement(&removable_node->key_, &temp_key);
   }
 }
 
@@ -454,11 +594,11 @@ void SelfBalancingBinarySearchTree::RemoveWhenSingleSon(Node* removable_node) {
 }
 
 void SelfBalancingBinarySearchTree::ReplaceWithSingleSonNode(Node* current_node, Node* replace_node) {
-  current_node->key_ = replace_node->key_;
+  MoveElement(&current_node->key_, &replace_node->key_);
   current_node->left_ = replace_node->left_;
   current_node->right_ = replace_node->right_;
   current_node->balance_ = 0;
-  delete replace_node;
+  arena_.Delete(replace_node);
 }
 
 void SelfBalancingBinarySearchTree::RemoveNode(Node* removable) {
@@ -466,11 +606,11 @@ void SelfBalancingBinarySearchTree::RemoveNode(Node* removable) {
   if (removable->left_ || removable->right_) throw std::runtime_error("removable node has son");
   if (parent) {
     if (parent->left_ == removable) {
-      delete parent->left_;
+      arena_.Delete(parent->left_);
       parent->left_ = nullptr;
       --parent->balance_;
     } else if (parent->right_ == removable) {
-      delete parent->right_;
+      arena_.Delete(parent->right_);
       parent->right_ = nullptr;
       ++parent->balance_;
     }
@@ -513,6 +653,10 @@ SelfBalancingBinarySearchTree::Node::Node(const Element& key, Node* parent)
 : key_(key)
 , parent_(parent) { }
 
+SelfBalancingBinarySearchTree::Node::Node(Element&& key, Node* parent)
+: key_(std::move(key))
+, parent_(parent) { }
+
 /* -------------------------------------------------------------------------- */
 /*                                vizualization                               */
 /* -------------------------------------------------------------------------- */
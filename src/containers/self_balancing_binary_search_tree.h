@@ -4,13 +4,17 @@
 #include <string>
 #include <vector>
 #include "../storage.h"
+#include "arena.h"
 
 namespace s21 {
 
+/* Nodes come from the arena of the tree, so Init drops a tree of short
+   keys by releasing the arena blocks instead of visiting every node. */
 class SelfBalancingBinarySearchTree : public Storage {
  public:
   struct Node {
     explicit Node(const Element& key, Node* parent = nullptr);
+    explicit Node(Element&& key, Node* parent = nullptr);
 
     Element key_;
     int balance_ = 0;
@@ -33,24 +37,43 @@ class SelfBalancingBinarySearchTree : public Storage {
   ~SelfBalancingBinarySearchTree();
 
   void Set(element element) override;
+  void Set(Element&& element) override;
   Storage::Element Get(const std::string& key) const override;
+  bool Visit(string key, const Visitor& visitor) const override;
+  void ForEach(const Visitor& visitor) const override;
+  /* single nodes and subtrees in the preorder of ForEach */
+  std::vector<Part> Split(size_t parts) const override;
+  /* keys in order, from the start of the prefix to its end */
+  std::string Scan(const std::string& cursor, string prefix, const ScanVisitor& visitor) const override;
   bool Exists(string key) const override;
   bool Del(string key) override;
   bool Update(string key, const Element::Data& data) override;
   bool Rename(string key, string new_key) override;
   int Ttl(string key) const override;
-  vector Find(const Storage::Element::Data& data) const override;
   void Init() override;
-  std::vector<Element> AllElements() const override;
   void Remove(const std::string& key);
   void TreeViz(const std::string &file_name);
 
  private:
   Node* root_ = nullptr;
+  Arena arena_;
+  /* set once a key longer than the inline string buffer was stored */
+  bool has_heap_keys_ = false;
   bool is_balanced_ = true;
   bool is_remove_ = false;
 
+  bool IsBulkLoaded() const override;
+  /* the records sorted, then a perfectly balanced tree made of them */
+  void Load(std::vector<Element>* elements) override;
+  /* the subtree of count records from elements and its height */
+  Node* BuildBalanced(Element* elements, size_t count, Node* parent, int* height);
   Node* FindNode(const std::string& key) const;
+  /* the first node with a key not less than key, greater when is_after */
+  const Node* LowerBound(const std::string& key, bool is_after) const;
+  static const Node* NextNode(const Node* node);
+  void Insert(Element&& element);
+  bool KeepsOrder(Node* node, string new_key);
+  static void MoveElement(Element* to, Element* from);
   void ReplaceWithSingleSonNode(Node* current_node, Node* right_node);
   void RemoveWhenTwoChildren(Node* removable_node);
   void RemoveWhenSingleSon(Node* removable_node);
@@ -78,6 +101,7 @@ class SelfBalancingBinarySearchTree : public Storage {
   void CalculateBalance(Node* current_node, const Node* previous_node);
 
   void GetElement(Node* node, std::vector<Node*>* vector) const;
+  void VisitNode(const Node* node, const Visitor& visitor) const;
   void PrintNode(Node* node, std::ofstream* out_stream);
 };
 
@@ -0,0 +1,354 @@
+#include "swiss_table.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "key_hash.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace s21 {
+
+using data_t = Storage::Element::Data;
+
+SwissTable::SwissTable() {
+  Init();
+}
+
+SwissTable::SwissTable(SwissTable const& other) {
+  CopyTable(other);
+}
+
+SwissTable::SwissTable(SwissTable&& other) {
+  Init();
+  SwapTable(&other);
+}
+
+SwissTable& SwissTable::operator=(SwissTable const& other) {
+  if (&other != this) {
+    Release();
+    CopyTable(other);
+  }
+  return *this;
+}
+
+SwissTable& SwissTable::operator=(SwissTable&& other) {
+  if (&other != this) SwapTable(&other);
+  return *this;
+}
+
+SwissTable::~SwissTable() {
+  Release();
+}
+
+inline void SwissTable::CopyTable(SwissTable const& other) {
+  Allocate(other.capacity_);
+  std::copy(other.control_.get(), other.control_.get() + capacity_, control_.get());
+  for (size_t slot = 0; slot < capacity_; ++slot) {
+    if (control_[slot] >= 0) new (&slots_[slot]) Element(other.slots_[slot]);
+  }
+  size_ = other.size_;
+  deleted_ = other.deleted_;
+  has_heap_keys_ = other.has_heap_keys_;
+}
+
+void SwissTable::SwapTable(SwissTable* other) {
+  std::swap(control_, other->control_);
+  std::swap(slots_, other->slots_);
+  std::swap(capacity_, other->capacity_);
+  std::swap(size_, other->size_);
+  std::swap(deleted_, other->deleted_);
+  std::swap(has_heap_keys_, other->has_heap_keys_);
+}
+
+void SwissTable::Set(element element) {
+  Set(Element(element));
+}
+
+void SwissTable::Set(Element&& element) {
+  const uint64_t hash = HashFunction(element.GetKey());
+  if (FindSlot(element.GetKey(), hash) == kNoSlot) {
+    Reserve();
+    InsertElement(std::move(element), hash);
+  }
+}
+
+Storage::Element SwissTable::Get(string key) const {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return Element();
+  return slots_[slot];
+}
+
+bool SwissTable::Visit(string key, const Visitor& visitor) const {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return false;
+  visitor(slots_[slot]);
+  return true;
+}
+
+bool SwissTable::Exists(string key) const {
+  return FindSlot(key, HashFunction(key)) != kNoSlot;
+}
+
+bool SwissTable::Del(string key) {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return false;
+  EraseSlot(slot);
+  return true;
+}
+
+bool SwissTable::Update(string key, const data_t &data) {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return false;
+  Element& element = slots_[slot];
+  element.UpdateData(data);
+  return true;
+}
+
+bool SwissTable::Rename(string key, string new_key) {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return false;
+  if (key == new_key) return true;
+  const uint64_t new_hash = HashFunction(new_key);
+  if (FindSlot(new_key, new_hash) != kNoSlot) return false;
+  Element element(std::move(slots_[slot]));
+  element.SetKey(new_key);
+  EraseSlot(slot);
+  Reserve();
+  InsertElement(std::move(element), new_hash);
+  return true;
+}
+
+int SwissTable::Ttl(string key) const {
+  size_t slot = FindSlot(key, HashFunction(key));
+  if (slot == kNoSlot) return 0;
+  return slots_[slot].GetLifeTime();
+}
+
+void SwissTable::ForEach(const Visitor& visitor) const {
+  for (size_t slot = 0; slot < capacity_; ++slot) {
+    if (control_[slot] >= 0) visitor(slots_[slot]);
+  }
+}
+
+std::vector<Storage::Part> SwissTable::Split(size_t parts) const {
+  const size_t count = PartsFor(size_, parts);
+  std::vector<Part> result;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t begin = capacity_ * i / count;
+    const size_t end = capacity_ * (i + 1) / count;
+    result.push_back([this, begin, end](const Visitor& visitor) {
+      for (size_t slot = begin; slot < end; ++slot) {
+        if (control_[slot] >= 0) visitor(slots_[slot]);
+      }
+    });
+  }
+  return result;
+}
+
+/* a rehash moves the records to other slots but keeps their home groups
+   apart from the split of a doubling, so the cursor goes by home groups */
+std::string SwissTable::Scan(const std::string& cursor, string, const ScanVisitor& visitor) const {
+  size_t home = ParseCursor(cursor);
+  if (size_ == 0) return "0";
+  const size_t mask = capacity_ / kGroupWidth - 1;
+  bool is_more = true;
+  do {
+    is_more = VisitHome(home & mask, visitor);
+    home = NextBucket(home, mask);
+  } while (is_more && home != 0);
+  return std::to_string(home);
+}
+
+/* the records of a home group lie on its probe sequence before the first
+   group with an empty slot, the whole group is visited even when the
+   visitor stops early */
+bool SwissTable::VisitHome(size_t home, const ScanVisitor& visitor) const {
+  const size_t mask = capacity_ / kGroupWidth - 1;
+  bool is_more = true;
+  size_t group = home;
+  for (size_t step = 1; step <= mask + 1; ++step) {
+    const size_t first = group * kGroupWidth;
+    for (size_t slot = first; slot < first + kGroupWidth; ++slot) {
+      if (control_[slot] >= 0 && ((HashFunction(slots_[slot].GetKey()) >> 7) & mask) == home) {
+        is_more = visitor(slots_[slot]) && is_more;
+      }
+    }
+    if (Group(&control_[first]).MatchEmpty() != 0) break;
+    group = (group + step) & mask;
+  }
+  return is_more;
+}
+
+void SwissTable::Init() {
+  Release();
+  Allocate(kGroupWidth);
+}
+
+size_t SwissTable::Capacity() const {
+  return capacity_;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   slots                                    */
+/* -------------------------------------------------------------------------- */
+
+uint64_t SwissTable::HashFunction(const std::string& str) {
+  return KeyHash::Hash(str);
+}
+
+/* the low 7 bits go to the control byte, the rest picks the first group */
+int8_t SwissTable::ControlHash(uint64_t hash) {
+  return static_cast<int8_t>(hash & 0x7f);
+}
+
+/* groups are probed in triangular steps 1, 2, 3..., with a power of two
+   number of groups this visits every group once. A group holding an empty
+   slot ends the search: the key would have been put there. */
+size_t SwissTable::FindSlot(string key, uint64_t hash) const {
+  const size_t mask = capacity_ / kGroupWidth - 1;
+  const int8_t control_hash = ControlHash(hash);
+  size_t group = (hash >> 7) & mask;
+  for (size_t step = 1; step <= mask + 1; ++step) {
+    const size_t first = group * kGroupWidth;
+    Group current(&control_[first]);
+    for (uint32_t match = current.Match(control_hash); match != 0; match &= match - 1) {
+      const size_t slot = first + __builtin_ctz(match);
+      if (slots_[slot].GetKey() == key) return slot;
+    }
+    if (current.MatchEmpty() != 0) break;
+    group = (group + step) & mask;
+  }
+  return kNoSlot;
+}
+
+size_t SwissTable::FindFreeSlot(uint64_t hash) const {
+  const size_t mask = capacity_ / kGroupWidth - 1;
+  size_t group = (hash >> 7) & mask;
+  for (size_t step = 1;; ++step) {
+    const size_t first = group * kGroupWidth;
+    uint32_t match = Group(&control_[first]).MatchEmptyOrDeleted();
+    if (match != 0) return first + __builtin_ctz(match);
+    group = (group + step) & mask;
+  }
+}
+
+void SwissTable::InsertElement(Element&& element, uint64_t hash) {
+  size_t slot = FindFreeSlot(hash);
+  if (control_[slot] == kDeleted) --deleted_;
+  control_[slot] = ControlHash(hash);
+  has_heap_keys_ |= !Element::IsInlineKey(element.GetKey());
+  new (&slots_[slot]) Element(std::move(element));
+  ++size_;
+}
+
+/* a slot may become empty again only if its group already has an empty one:
+   then no probe has ever gone past this group. Otherwise it is marked
+   deleted so lookups keep probing. */
+void SwissTable::EraseSlot(size_t slot) {
+  slots_[slot].~Element();
+  const size_t first = slot / kGroupWidth * kGroupWidth;
+  if (Group(&control_[first]).MatchEmpty() != 0) {
+    control_[slot] = kEmpty;
+  } else {
+    control_[slot] = kDeleted;
+    ++deleted_;
+  }
+  --size_;
+}
+
+/* makes room for one more record: doubles the table, or only sweeps the
+   deleted markers when most of the used slots are deleted ones */
+void SwissTable::Reserve() {
+  if ((size_ + deleted_ + 1) * kLoadDenominator <= capacity_ * kLoadNumerator) return;
+  if ((size_ + 1) * kLoadDenominator * 2 <= capacity_ * kLoadNumerator) {
+    Rehash(capacity_);
+  } else {
+    Rehash(capacity_ * 2);
+  }
+}
+
+void SwissTable::Rehash(size_t capacity) {
+  std::unique_ptr<int8_t[]> old_control = std::move(control_);
+  Element* old_slots = slots_;
+  const size_t old_capacity = capacity_;
+  slots_ = nullptr;
+  Allocate(capacity);
+  for (size_t slot = 0; slot < old_capacity; ++slot) {
+    if (old_control[slot] >= 0) {
+      const uint64_t hash = HashFunction(old_slots[slot].GetKey());
+      InsertElement(std::move(old_slots[slot]), hash);
+      old_slots[slot].~Element();
+    }
+  }
+  ::operator delete(old_slots);
+}
+
+void SwissTable::Allocate(size_t capacity) {
+  control_.reset(new int8_t[capacity]);
+  std::memset(control_.get(), kEmpty, capacity);
+  slots_ = static_cast<Element*>(::operator new(capacity * sizeof(Element)));
+  capacity_ = capacity;
+  size_ = 0;
+  deleted_ = 0;
+}
+
+void SwissTable::Release() {
+  for (size_t slot = 0; has_heap_keys_ && slot < capacity_; ++slot) {
+    if (control_[slot] >= 0) slots_[slot].~Element();
+  }
+  ::operator delete(slots_);
+  slots_ = nullptr;
+  control_.reset();
+  capacity_ = 0;
+  size_ = 0;
+  deleted_ = 0;
+  has_heap_keys_ = false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Group                                    */
+/* -------------------------------------------------------------------------- */
+
+SwissTable::Group::Group(const int8_t* control) : control_(control) {}
+
+#ifdef __SSE2__
+
+uint32_t SwissTable::Group::Match(int8_t hash) const {
+  const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control_));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), control));
+}
+
+uint32_t SwissTable::Group::MatchEmpty() const {
+  return Match(kEmpty);
+}
+
+/* only the two markers are negative, so the sign bits are the answer */
+uint32_t SwissTable::Group::MatchEmptyOrDeleted() const {
+  return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control_)));
+}
+
+#else
+
+uint32_t SwissTable::Group::Match(int8_t hash) const {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    if (control_[i] == hash) mask |= 1u << i;
+  }
+  return mask;
+}
+
+uint32_t SwissTable::Group::MatchEmpty() const {
+  return Match(kEmpty);
+}
+
+uint32_t SwissTable::Group::MatchEmptyOrDeleted() const {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    if (control_[i] < 0) mask |= 1u << i;
+  }
+  return mask;
+}
+
+#endif
+}  // namespace s21
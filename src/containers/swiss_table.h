@@ -0,0 +1,90 @@
+#ifndef SRC_CONTAINERS_SWISS_TABLE_H_
+#define SRC_CONTAINERS_SWISS_TABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include "../storage.h"
+
+namespace s21 {
+
+/* Open addressing in the style of Swiss tables. Next to the records the
+   table keeps one control byte per slot: the 7 low bits of the key hash for
+   a full slot, or a negative empty/deleted marker. Lookups probe whole
+   groups of 16 control bytes at once, with SSE2 compares where available,
+   so a miss or a hit at high load usually touches one group of control
+   bytes and at most one record. */
+class SwissTable : public Storage {
+ public:
+  using data_t = Storage::Element::Data;
+
+  SwissTable();
+  SwissTable(SwissTable const&);
+  SwissTable(SwissTable&&);
+  SwissTable& operator=(SwissTable const&);
+  SwissTable& operator=(SwissTable&&);
+  ~SwissTable();
+  void Set(element element) override;
+  void Set(Element&& element) override;
+  Element Get(string key) const override;
+  bool Visit(string key, const Visitor& visitor) const override;
+  void ForEach(const Visitor& visitor) const override;
+  /* runs of slots */
+  std::vector<Part> Split(size_t parts) const override;
+  /* the cursor is a home group, see Storage::NextBucket */
+  std::string Scan(const std::string& cursor, string prefix, const ScanVisitor& visitor) const override;
+  bool Exists(string key) const override;
+  bool Del(string key) override;
+  bool Update(string key, const data_t& data) override;
+  bool Rename(string key, string new_key) override;
+  int Ttl(string key) const override;
+  void Init() override;
+  size_t Capacity() const;
+
+ private:
+  static constexpr size_t kGroupWidth = 16;
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+  static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+  /* full and deleted slots together stay below 7/8 of the capacity */
+  static constexpr size_t kLoadNumerator = 7;
+  static constexpr size_t kLoadDenominator = 8;
+
+  /* bit i of a mask is set when control byte i of the group matches */
+  class Group {
+   public:
+    explicit Group(const int8_t* control);
+    uint32_t Match(int8_t hash) const;
+    uint32_t MatchEmpty() const;
+    uint32_t MatchEmptyOrDeleted() const;
+
+   private:
+    const int8_t* control_;
+  };
+
+  std::unique_ptr<int8_t[]> control_;
+  /* raw storage, only slots with a full control byte hold a live record */
+  Element* slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t deleted_ = 0;
+  /* set once a key longer than the inline string buffer was stored, until
+     then Release frees the slots without destroying the records */
+  bool has_heap_keys_ = false;
+
+  static uint64_t HashFunction(const std::string& str);
+  static int8_t ControlHash(uint64_t hash);
+  size_t FindSlot(string key, uint64_t hash) const;
+  size_t FindFreeSlot(uint64_t hash) const;
+  bool VisitHome(size_t home, const ScanVisitor& visitor) const;
+  void InsertElement(Element&& element, uint64_t hash);
+  void EraseSlot(size_t slot);
+  void Reserve();
+  void Rehash(size_t capacity);
+  void Allocate(size_t capacity);
+  void Release();
+  inline void CopyTable(SwissTable const& other);
+  void SwapTable(SwissTable* other);
+};
+}  // namespace s21
+
+#endif  // SRC_CONTAINERS_SWISS_TABLE_H_
@@ -1,8 +1,11 @@
 #include "holder.h"
+#include <algorithm>
 #include <ctime>
 #include <thread>
 #include "containers/self_balancing_binary_search_tree.h"
 #include "containers/hash_table.h"
+#include "containers/concurrent_hash_table.h"
+#include "containers/swiss_table.h"
 #include "containers/b_plus_tree.h"
 
 namespace s21 {
@@ -10,110 +13,283 @@ namespace s21 {
 Holder::Holder(const StorageType& type) {
   if (type == Holder::StorageType::kHashTable) {
     storage_ = new HashTable();
+  } else if (type == Holder::StorageType::kSwissTable) {
+    storage_ = new SwissTable();
+  } else if (type == Holder::StorageType::kConcurrentHashTable) {
+    storage_ = new ConcurrentHashTable();
   } else if (type == Holder::StorageType::kAVL) {
     storage_ = new SelfBalancingBinarySearchTree();
   } else if (type == Holder::StorageType::kBTree) {
     storage_ = new BPlusTree();
   }
-  std::thread cleaner = std::thread(&Holder::LifeTimeRemover, this, std::ref(safe_list_),
+  is_concurrent_ = storage_ && storage_->IsThreadSafe();
+  is_ordered_ = type == StorageType::kAVL || type == StorageType::kBTree;
+  cleaner_ = std::thread(&Holder::LifeTimeRemover, this, std::ref(safe_list_),
                       std::ref(update_), std::ref(is_run_));
-  cleaner.detach();
 }
 
 Holder::~Holder() {
+  is_run_ = false;
+  cleaner_.join();
   if (storage_) {
-    is_run_ = false;
     delete storage_;
     storage_ = nullptr;
   }
 }
 
 void Holder::Set(element element) {
-  std::lock_guard lock(mtx_);
-  const int life_time = element.GetData().life_time;
+  Set(Storage::Element(element));
+}
+
+void Holder::Set(Storage::Element&& element) {
+  auto lock = Lock();
+  const int life_time = element.GetLifeTime();
   if (life_time != kDefault_life_time) {
     AddToTemporaryList(element.GetKey(), life_time);
     update_ = true;
   }
-  storage_->Set(element);
+  if (IsShadowed() && !storage_->Exists(element.GetKey())) Track(element.GetKey(), element.GetRecord());
+  storage_->Set(std::move(element));
 }
 
 bool Holder::Del(string key) {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   const int ttl = storage_->Ttl(key);
   if (ttl != 0 && ttl != kDefault_life_time) {
     RemoveFromTemporaryList(key);
     update_ = true;
   }
+  Storage::Element::Record record;
+  if (IsShadowed() && FindRecord(key, &record)) Untrack(key, record);
   return storage_->Del(key);
 }
 
+/* only keys with a life time are in the list, so the storage is not asked
+   for the life time of the key */
 bool Holder::Rename(string key, string new_key) {
-  std::lock_guard lock(mtx_);
-  const int ttl = storage_->Ttl(key);
-  if (ttl != 0 && ttl != kDefault_life_time) {
-    RenameTemporaryKey(key, new_key);
-    update_ = true;
+  auto lock = Lock();
+  if (!storage_->Rename(key, new_key)) return false;
+  if (key != new_key && RenameTemporaryKey(key, new_key)) update_ = true;
+  Storage::Element::Record record;
+  if (key != new_key && IsShadowed() && FindRecord(new_key, &record)) {
+    Untrack(key, record);
+    Track(new_key, record);
   }
-  return storage_->Rename(key, new_key);
+  return true;
 }
 
 Storage::Element Holder::Get(string key) const {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->Get(key);
 }
 
+bool Holder::Visit(string key, const Storage::Visitor& visitor) const {
+  auto lock = Lock();
+  return storage_->Visit(key, visitor);
+}
+
 bool Holder::Exists(string key) const {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->Exists(key);
 }
 
 bool Holder::Update(string key, const Storage::Element::Data& data) {
-  std::lock_guard lock(mtx_);
-  return storage_->Update(key, data);
+  auto lock = Lock();
+  Storage::Element::Record record;
+  if (!IsShadowed() || !FindRecord(key, &record)) return storage_->Update(key, data);
+  Untrack(key, record);
+  const bool result = storage_->Update(key, data);
+  FindRecord(key, &record);
+  Track(key, record);
+  return result;
 }
 
 std::vector<std::string> Holder::Keys() {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->Keys();
 }
 
+std::string Holder::Scan(string cursor, string pattern, size_t count, vector* keys) const {
+  const std::string prefix = Storage::LiteralPrefix(pattern);
+  size_t visited = 0;
+  auto lock = Lock();
+  return storage_->Scan(cursor, prefix, [&pattern, count, keys, &visited](const Storage::Element& element) {
+    if (Storage::IsKeyMatch(pattern, element.GetKey())) keys->push_back(element.GetKey());
+    return ++visited < count;
+  });
+}
+
 int Holder::Ttl(string key) const {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->Ttl(key);
 }
 
 std::vector<std::string> Holder::Find(const Storage::Element::Data& data) const {
-  std::lock_guard lock(mtx_);
-  return storage_->Find(data);
+  return Find(Storage::Element::EncodeQuery(data));
+}
+
+/* the rows of the driver are intersected with the filters, the records
+   are read only when the plan leaves a part of the query unchecked */
+std::vector<std::string> Holder::Find(const Storage::Element::Query& query, SecondaryIndex::Plan* plan) const {
+  auto lock = Lock();
+  SecondaryIndex::Plan chosen = index_.HasFields() ? index_.MakePlan(query) : SecondaryIndex::Plan();
+  vector result;
+  auto check = [&result, &query, &chosen](const Storage::Element& element) {
+    ++chosen.rows_examined;
+    if (Storage::IsDataSiutable(query, element.GetRecord())) result.push_back(element.GetKey());
+  };
+  if (chosen.is_scan && is_columnar_) {
+    chosen.is_columnar = true;
+    chosen.rows_examined = columns_.Size();
+    result = columns_.Find(query);
+  } else if (chosen.is_scan) {
+    result = storage_->Find(query, &chosen.rows_examined);
+  } else {
+    index_.Rows(chosen).ForEach([this, &result, &chosen, &check](uint32_t row) {
+      const std::string& key = index_.KeyOf(row);
+      if (chosen.is_checked) {
+        storage_->Visit(key, check);
+      } else {
+        result.push_back(key);
+      }
+    });
+  }
+  if (is_ordered_ && !std::is_sorted(result.begin(), result.end())) std::sort(result.begin(), result.end());
+  if (plan) *plan = std::move(chosen);
+  return result;
 }
 
 std::vector<Storage::Element::Data> Holder::ShowAll() {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->ShowAll();
 }
 
 int Holder::Upload(string file_name) {
-  std::lock_guard lock(mtx_);
-  return storage_->Upload(file_name);
+  auto lock = Lock();
+  try {
+    const int count = storage_->Upload(file_name);
+    RebuildShadows();
+    return count;
+  } catch (...) {
+    RebuildShadows();
+    throw;
+  }
 }
 
 int Holder::Export(string file_name) {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->Export(file_name);
 }
 
 void Holder::Init() {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   storage_->Init();
+  index_.Clear();
+  columns_.Clear();
+  aggregates_.Clear();
 }
 
 std::vector<Storage::Element> Holder::AllElements() {
-  std::lock_guard lock(mtx_);
+  auto lock = Lock();
   return storage_->AllElements();
 }
 
+void Holder::ForEach(const Storage::Visitor& visitor) const {
+  auto lock = Lock();
+  storage_->ForEach(visitor);
+}
+
+void Holder::AddIndex(SecondaryIndex::Field field) {
+  std::unique_lock lock(mtx_);
+  index_.AddField(field, *storage_);
+}
+
+void Holder::DropIndex(SecondaryIndex::Field field) {
+  std::unique_lock lock(mtx_);
+  index_.DropField(field);
+}
+
+bool Holder::IsIndexed(SecondaryIndex::Field field) const {
+  auto lock = Lock();
+  return index_.IsIndexed(field);
+}
+
+void Holder::SetColumnar(bool is_columnar) {
+  std::unique_lock lock(mtx_);
+  if (is_columnar == is_columnar_) return;
+  is_columnar_ = is_columnar;
+  if (is_columnar_) {
+    columns_.Rebuild(*storage_);
+  } else {
+    columns_.Clear();
+  }
+}
+
+bool Holder::IsColumnar() const {
+  auto lock = Lock();
+  return is_columnar_;
+}
+
+std::vector<Aggregates::Row> Holder::Aggregate(Aggregates::Grouping grouping) {
+  std::unique_lock lock(mtx_);
+  aggregates_.AddGrouping(grouping, *storage_);
+  return aggregates_.Rows(grouping);
+}
+
+bool Holder::Aggregate(Aggregates::Grouping grouping, string group, Aggregates::Summary* summary) {
+  std::unique_lock lock(mtx_);
+  aggregates_.AddGrouping(grouping, *storage_);
+  return aggregates_.Find(grouping, group, summary);
+}
+
+void Holder::DropAggregate(Aggregates::Grouping grouping) {
+  std::unique_lock lock(mtx_);
+  aggregates_.DropGrouping(grouping);
+}
+
+Holder::Guard Holder::Lock() const {
+  return Guard(*this);
+}
+
+/* the shadows change only under the exclusive lock, so they are looked at
+   under the shared one */
+Holder::Guard::Guard(const Holder& holder) {
+  if (holder.is_concurrent_) {
+    shared_ = std::shared_lock(holder.mtx_);
+    if (!holder.IsShadowed()) return;
+    shared_.unlock();
+  }
+  exclusive_ = std::unique_lock(holder.mtx_);
+}
+
+bool Holder::FindRecord(string key, Storage::Element::Record* record) const {
+  return storage_->Visit(key, [record](const Storage::Element& element) { *record = element.GetRecord(); });
+}
+
+bool Holder::IsShadowed() const {
+  return is_columnar_ || index_.HasFields() || aggregates_.HasGroupings();
+}
+
+void Holder::Track(string key, const Storage::Element::Record& record) {
+  if (index_.HasFields()) index_.Insert(key, record);
+  if (is_columnar_) columns_.Insert(key, record);
+  if (aggregates_.HasGroupings()) aggregates_.Insert(record);
+}
+
+void Holder::Untrack(string key, const Storage::Element::Record& record) {
+  if (index_.HasFields()) index_.Erase(key, record);
+  if (is_columnar_) columns_.Erase(key);
+  if (aggregates_.HasGroupings()) aggregates_.Erase(record);
+}
+
+void Holder::RebuildShadows() {
+  if (index_.HasFields()) index_.Rebuild(*storage_);
+  if (is_columnar_) columns_.Rebuild(*storage_);
+  if (aggregates_.HasGroupings()) aggregates_.Rebuild(*storage_);
+}
+
 void Holder::AddToTemporaryList(string key, int time) {
+  std::lock_guard lock(ttl_mtx_);
   std::pair<int, std::string> pair(time, key);
   if (safe_list_.GetListSize() > 0) {
     auto it = safe_list_.GetBeginList();
@@ -129,6 +305,7 @@ void Holder::AddToTemporaryList(string key, int time) {
 }
 
 void Holder::RemoveFromTemporaryList(string key) {
+  std::lock_guard lock(ttl_mtx_);
   for (auto it = safe_list_.GetBeginList(); it != safe_list_.GetEndList(); ++it) {
     if ((*it).second == key) {
       safe_list_.EraseList(it);
@@ -137,21 +314,25 @@ void Holder::RemoveFromTemporaryList(string key) {
   }
 }
 
-void Holder::RenameTemporaryKey(string key, string new_key) {
+bool Holder::RenameTemporaryKey(string key, string new_key) {
+  std::lock_guard lock(ttl_mtx_);
   for (auto it = safe_list_.GetBeginList(); it != safe_list_.GetEndList(); ++it) {
     if ((*it).second == key) {
       (*it).second = new_key;
-      break;
+      return true;
     }
   }
+  return false;
 }
 
-void Holder::LifeTimeRemover(Holder::SafeList& list, bool& update, const bool& is_run) {
+void Holder::LifeTimeRemover(Holder::SafeList& list, std::atomic<bool>& update,
+                             const std::atomic<bool>& is_run) {
   const int kMaxInt = 0x7fffffff;
   int time = kMaxInt;
   std::pair<int, std::string> element;
 
   while (is_run) {
+    std::this_thread::sleep_for(kRemoverPeriod);
     int current_time = std::time(nullptr);
     if (update) {
       if (list.GetListSize() > 0) {
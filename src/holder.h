@@ -1,10 +1,17 @@
 #ifndef SRC_HOLDER_H_
 #define SRC_HOLDER_H_
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <mutex>
+#include <shared_mutex>
 #include <list>
+#include <thread>
 #include "storage.h"
+#include "secondary_index.h"
+#include "column_store.h"
+#include "aggregates.h"
 
 namespace s21 {
 
@@ -17,6 +24,8 @@ class SafeList;
 
   enum class StorageType {
     kHashTable,
+    kSwissTable,
+    kConcurrentHashTable,
     kAVL,
     kBTree,
     kEmpty
@@ -30,21 +39,48 @@ class SafeList;
   ~Holder();
 
   void Set(element element);
+  void Set(Storage::Element&& element);
   Storage::Element Get(string key) const;
+  /* the visitor runs under the storage lock */
+  bool Visit(string key, const Storage::Visitor& visitor) const;
   bool Exists(string key) const;
   bool Del(string key);
   bool Update(string key, const Storage::Element::Data& data);
   vector Keys();
+  /* a step of SCAN over about count records from the cursor: the keys that
+     match the pattern go to keys, returns the cursor of the next step */
+  std::string Scan(string cursor, string pattern, size_t count, vector* keys) const;
   bool Rename(string key, string new_key);
   int Ttl(string key) const;
   vector Find(const Storage::Element::Data& data) const;
+  /* fills the plan when asked, EXPLAIN FIND shows it. The trees give the
+     keys in key order whatever the plan. */
+  vector Find(const Storage::Element::Query& query, SecondaryIndex::Plan* plan = nullptr) const;
   std::vector<Storage::Element::Data> ShowAll();
   int Upload(string file_name);
   int Export(string file_name);
   void Init();
   std::vector<Storage::Element> AllElements();
+  /* the whole walk runs under the storage lock */
+  void ForEach(const Storage::Visitor& visitor) const;
+  /* FIND then starts from the keys with the value of an indexed field. The
+     index is built while the other commands wait. */
+  void AddIndex(SecondaryIndex::Field field);
+  void DropIndex(SecondaryIndex::Field field);
+  bool IsIndexed(SecondaryIndex::Field field) const;
+  /* FIND that has to scan then reads columns of the records; the columns
+     are built while the other commands wait */
+  void SetColumnar(bool is_columnar);
+  bool IsColumnar() const;
+  /* coins by city or year; the first call builds the groups while the
+     other commands wait, later calls read them as the commands keep them.
+     Kept groups make every command of a concurrent engine take the lock
+     exclusively until they are dropped. */
+  std::vector<Aggregates::Row> Aggregate(Aggregates::Grouping grouping);
+  bool Aggregate(Aggregates::Grouping grouping, string group, Aggregates::Summary* summary);
+  void DropAggregate(Aggregates::Grouping grouping);
 
-  void LifeTimeRemover(SafeList& list, bool& update, const bool& is_run);
+  void LifeTimeRemover(SafeList& list, std::atomic<bool>& update, const std::atomic<bool>& is_run);
 
 
  private:
@@ -67,16 +103,49 @@ class SafeList;
     std::list<std::pair<int, std::string>> temporary_keys_list_;
   };
 
-  bool update_ = false;
-  bool is_run_ = true;
+  std::atomic<bool> update_ = false;
+  std::atomic<bool> is_run_ = true;
   static const int kDefault_life_time = -1;
-  mutable std::mutex mtx_;
+  /* life times are counted in seconds, the remover wakes up this often */
+  static constexpr std::chrono::milliseconds kRemoverPeriod{10};
+  /* A command holds mtx_ while it runs. Engines that lock themselves are
+     called with mtx_ shared, the list of expiring keys still needs a lock
+     of its own. With an index, columns or aggregates every command holds
+     mtx_ exclusively, so they change with the records; they are added and
+     dropped with mtx_ held exclusively too. */
+  mutable std::shared_mutex mtx_;
+  bool is_concurrent_ = false;
+  /* the trees: FIND sorts what the index or the columns find */
+  bool is_ordered_ = false;
+  std::mutex ttl_mtx_;
   Storage* storage_;
+  SecondaryIndex index_;
+  bool is_columnar_ = false;
+  ColumnStore columns_;
+  Aggregates aggregates_;
   SafeList safe_list_;
+  std::thread cleaner_;
 
+  /* mtx_ shared or exclusive, as the command needs it */
+  class Guard {
+   public:
+    explicit Guard(const Holder& holder);
+
+   private:
+    std::shared_lock<std::shared_mutex> shared_;
+    std::unique_lock<std::shared_mutex> exclusive_;
+  };
+
+  Guard Lock() const;
   void AddToTemporaryList(string key, int time);
   void RemoveFromTemporaryList(string key);
-  void RenameTemporaryKey(string key, string new_key);
+  bool RenameTemporaryKey(string key, string new_key);
+  bool FindRecord(string key, Storage::Element::Record* record) const;
+  /* the index, the columns and the aggregates are shadows of the records */
+  bool IsShadowed() const;
+  void Track(string key, const Storage::Element::Record& record);
+  void Untrack(string key, const Storage::Element::Record& record);
+  void RebuildShadows();
 };
 
 }  // namespace s21
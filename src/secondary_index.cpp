@@ -0,0 +1,245 @@
+#include "secondary_index.h"
+#include <algorithm>
+#include "string_pool.h"
+
+namespace s21 {
+
+namespace {
+
+const char* const kFieldNames[SecondaryIndex::kFieldsCount] = {"surname", "name", "year", "city", "coins"};
+
+/* a value without rows is removed, so the maps hold only live values */
+template <typename Map, typename Value>
+void EraseRow(Map* postings, const Value& value, uint32_t row) {
+  auto it = postings->find(value);
+  if (it == postings->end()) return;
+  it->second.Remove(row);
+  if (it->second.Empty()) postings->erase(it);
+}
+
+}  // namespace
+
+bool SecondaryIndex::ParseField(const std::string& name, Field* field) {
+  for (int i = 0; i < kFieldsCount; ++i) {
+    if (name == kFieldNames[i]) {
+      *field = static_cast<Field>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* SecondaryIndex::FieldName(Field field) {
+  return kFieldNames[field];
+}
+
+void SecondaryIndex::AddField(Field field, const Storage& storage) {
+  if (is_indexed_[field]) return;
+  const bool is_first = !HasFields();
+  if (is_first) Clear();
+  is_indexed_[field] = true;
+  storage.ForEach([this, field, is_first](const Storage::Element& element) {
+    const uint32_t row = is_first ? AddRow(element.GetKey()) : rows_.find(element.GetKey())->second;
+    AddToField(field, element.GetRecord(), row);
+  });
+}
+
+void SecondaryIndex::DropField(Field field) {
+  is_indexed_[field] = false;
+  codes_[field].clear();
+  numbers_[field].clear();
+  if (!HasFields()) Clear();
+}
+
+bool SecondaryIndex::IsIndexed(Field field) const {
+  return is_indexed_[field];
+}
+
+bool SecondaryIndex::HasFields() const {
+  for (bool is_indexed : is_indexed_) {
+    if (is_indexed) return true;
+  }
+  return false;
+}
+
+void SecondaryIndex::Insert(const std::string& key, const Record& record) {
+  const uint32_t row = AddRow(key);
+  for (int i = 0; i < kFieldsCount; ++i) {
+    if (is_indexed_[i]) AddToField(static_cast<Field>(i), record, row);
+  }
+}
+
+void SecondaryIndex::Erase(const std::string& key, const Record& record) {
+  uint32_t row;
+  if (!RemoveRow(key, &row)) return;
+  for (int i = 0; i < kFieldsCount; ++i) {
+    const Field field = static_cast<Field>(i);
+    if (!is_indexed_[i]) continue;
+    if (IsNumber(field)) {
+      EraseRow(&numbers_[i], NumberOf(record, field), row);
+    } else {
+      EraseRow(&codes_[i], CodeOf(record, field), row);
+    }
+  }
+}
+
+void SecondaryIndex::Clear() {
+  rows_.clear();
+  keys_.clear();
+  free_rows_.clear();
+  for (auto& postings : codes_) postings.clear();
+  for (auto& postings : numbers_) postings.clear();
+}
+
+void SecondaryIndex::Rebuild(const Storage& storage) {
+  Clear();
+  storage.ForEach([this](const Storage::Element& element) {
+    Insert(element.GetKey(), element.GetRecord());
+  });
+}
+
+const std::string& SecondaryIndex::KeyOf(uint32_t row) const {
+  return keys_[row];
+}
+
+size_t SecondaryIndex::Records() const {
+  return rows_.size();
+}
+
+size_t SecondaryIndex::Bytes() const {
+  size_t bytes = 0;
+  for (const auto& postings : codes_) {
+    for (const auto& value : postings) bytes += value.second.Bytes();
+  }
+  for (const auto& postings : numbers_) {
+    for (const auto& value : postings) bytes += value.second.Bytes();
+  }
+  return bytes;
+}
+
+SecondaryIndex::Plan SecondaryIndex::MakePlan(const Query& query) const {
+  Plan plan;
+  plan.records = Records();
+  std::vector<Predicate> predicates;
+  size_t given = 0;
+  for (int i = 0; i < kFieldsCount; ++i) {
+    const Field field = static_cast<Field>(i);
+    if (!IsGiven(query, field)) continue;
+    ++given;
+    if (is_indexed_[i]) predicates.push_back(MakePredicate(query, field));
+  }
+  if (predicates.empty()) return plan;
+  std::sort(predicates.begin(), predicates.end(),
+            [](const Predicate& left, const Predicate& right) { return left.rows < right.rows; });
+  /* a filter is worth its AND while it is cheaper than reading the rows
+     of the driver */
+  std::vector<Predicate> filters;
+  size_t rows = predicates[0].rows;
+  for (size_t i = 1; i < predicates.size(); ++i) {
+    if (predicates[i].rows * kRowCost > predicates[0].rows * kVisitCost) continue;
+    rows += predicates[i].rows;
+    filters.push_back(std::move(predicates[i]));
+  }
+  const bool is_checked = given > 1 + filters.size();
+  const size_t cost = rows * kRowCost + (is_checked ? predicates[0].rows * kVisitCost : 0);
+  if (cost >= plan.records * kScanCost) return plan;
+  plan.is_scan = false;
+  plan.driver = std::move(predicates[0]);
+  plan.filters = std::move(filters);
+  plan.is_checked = is_checked;
+  return plan;
+}
+
+RoaringBitmap SecondaryIndex::Rows(const Plan& plan) const {
+  RoaringBitmap rows = plan.driver.Union();
+  for (const Predicate& filter : plan.filters) {
+    if (rows.Empty()) break;
+    rows.And(filter.Union());
+  }
+  return rows;
+}
+
+/* an empty range or an unknown text finds nothing */
+SecondaryIndex::Predicate SecondaryIndex::MakePredicate(const Query& query, Field field) const {
+  Predicate predicate;
+  predicate.field = field;
+  if (IsNumber(field)) {
+    const Storage::Element::Range range = RangeOf(query, field);
+    if (range.min > range.max) return predicate;
+    auto end = numbers_[field].upper_bound(range.max);
+    for (auto it = numbers_[field].lower_bound(range.min); it != end; ++it) {
+      predicate.bitmaps.push_back(&it->second);
+      predicate.rows += it->second.Cardinality();
+    }
+  } else {
+    auto it = codes_[field].find(CodeOf(query, field));
+    if (it == codes_[field].end()) return predicate;
+    predicate.bitmaps.push_back(&it->second);
+    predicate.rows = it->second.Cardinality();
+  }
+  return predicate;
+}
+
+RoaringBitmap SecondaryIndex::Predicate::Union() const {
+  if (bitmaps.size() == 1) return *bitmaps[0];
+  RoaringBitmap rows;
+  for (const RoaringBitmap* bitmap : bitmaps) rows.Or(*bitmap);
+  return rows;
+}
+
+bool SecondaryIndex::IsNumber(Field field) {
+  return field == kYearOfBirth || field == kCoins;
+}
+
+int32_t SecondaryIndex::NumberOf(const Record& record, Field field) {
+  return field == kYearOfBirth ? record.year_of_birth : record.coins;
+}
+
+uint32_t SecondaryIndex::CodeOf(const Record& record, Field field) {
+  return field == kSurname ? record.surname : field == kName ? record.name : record.city;
+}
+
+uint32_t SecondaryIndex::CodeOf(const Query& query, Field field) {
+  return field == kSurname ? query.surname : field == kName ? query.name : query.city;
+}
+
+Storage::Element::Range SecondaryIndex::RangeOf(const Query& query, Field field) {
+  return field == kYearOfBirth ? query.year_of_birth : query.coins;
+}
+
+bool SecondaryIndex::IsGiven(const Query& query, Field field) {
+  return IsNumber(field) ? !RangeOf(query, field).IsAll() : CodeOf(query, field) != StringPool::kEmptyCode;
+}
+
+uint32_t SecondaryIndex::AddRow(const std::string& key) {
+  uint32_t row = keys_.size();
+  if (free_rows_.empty()) {
+    keys_.push_back(key);
+  } else {
+    row = free_rows_.back();
+    free_rows_.pop_back();
+    keys_[row] = key;
+  }
+  rows_.emplace(keys_[row], row);
+  return row;
+}
+
+bool SecondaryIndex::RemoveRow(const std::string& key, uint32_t* row) {
+  auto it = rows_.find(key);
+  if (it == rows_.end()) return false;
+  *row = it->second;
+  rows_.erase(it);
+  std::string().swap(keys_[*row]);
+  free_rows_.push_back(*row);
+  return true;
+}
+
+void SecondaryIndex::AddToField(Field field, const Record& record, uint32_t row) {
+  if (IsNumber(field)) {
+    numbers_[field][NumberOf(record, field)].Add(row);
+  } else {
+    codes_[field][CodeOf(record, field)].Add(row);
+  }
+}
+
+}  // namespace s21
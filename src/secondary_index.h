@@ -0,0 +1,119 @@
+#ifndef SRC_SECONDARY_INDEX_H_
+#define SRC_SECONDARY_INDEX_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "storage.h"
+#include "containers/roaring_bitmap.h"
+
+namespace s21 {
+
+/* Optional indexes of record fields. Every indexed record gets a dense row
+   id, freed ids are given out again, and for every indexed field a map goes
+   from the field value to the bitmap of the rows that have it. Text fields
+   are hashed by their StringPool codes, year and coins are kept ordered so
+   a range is found in O(log n). The owner keeps the index in step with the
+   storage and synchronizes the calls. */
+class SecondaryIndex {
+ public:
+  using Record = Storage::Element::Record;
+  using Query = Storage::Element::Query;
+
+  enum Field {
+    kSurname,
+    kName,
+    kYearOfBirth,
+    kCity,
+    kCoins,
+    kFieldsCount
+  };
+
+  /* surname, name, year, city or coins */
+  static bool ParseField(const std::string& name, Field* field);
+  static const char* FieldName(Field field);
+
+  /* builds the index of the field from the records of the storage */
+  void AddField(Field field, const Storage& storage);
+  void DropField(Field field);
+  bool IsIndexed(Field field) const;
+  bool HasFields() const;
+
+  void Insert(const std::string& key, const Record& record);
+  void Erase(const std::string& key, const Record& record);
+  /* forgets all keys, the fields stay indexed */
+  void Clear();
+  void Rebuild(const Storage& storage);
+
+  /* the rows of an indexed field that match its part of the query, one
+     bitmap per value, so a range of values gives several */
+  struct Predicate {
+    Field field = kSurname;
+    size_t rows = 0;
+    std::vector<const RoaringBitmap*> bitmaps;
+
+    RoaringBitmap Union() const;
+  };
+
+  /* How FIND reads the records. An index plan takes the rows of the
+     driver, ANDs them with the filters and reads the records left only
+     when the query has fields the index plan does not cover. */
+  struct Plan {
+    bool is_scan = true;
+    Predicate driver;
+    std::vector<Predicate> filters;
+    bool is_checked = true;
+    size_t records = 0;
+    /* filled by whoever runs the plan */
+    bool is_columnar = false;
+    size_t rows_examined = 0;
+  };
+
+  /* the cheapest of a full scan and an index plan driven by the most
+     selective indexed field; counts of every value are exact, so the
+     statistics are the posting lists themselves */
+  Plan MakePlan(const Query& query) const;
+  /* the rows an index plan leaves */
+  RoaringBitmap Rows(const Plan& plan) const;
+  const std::string& KeyOf(uint32_t row) const;
+  size_t Records() const;
+  /* heap bytes of the bitmaps */
+  size_t Bytes() const;
+
+ private:
+  /* relative costs: a record read by key, a record of a scan, a row of a
+     bitmap operation */
+  static constexpr size_t kVisitCost = 32;
+  static constexpr size_t kScanCost = 8;
+  static constexpr size_t kRowCost = 1;
+
+  bool is_indexed_[kFieldsCount] = {};
+  /* a deque does not move its strings, so the views of rows_ stay valid */
+  std::deque<std::string> keys_;
+  std::unordered_map<std::string_view, uint32_t> rows_;
+  std::vector<uint32_t> free_rows_;
+  /* surname, name and city */
+  std::unordered_map<uint32_t, RoaringBitmap> codes_[kFieldsCount];
+  /* year and coins */
+  std::map<int32_t, RoaringBitmap> numbers_[kFieldsCount];
+
+  static bool IsNumber(Field field);
+  static int32_t NumberOf(const Record& record, Field field);
+  static uint32_t CodeOf(const Record& record, Field field);
+  static uint32_t CodeOf(const Query& query, Field field);
+  static Storage::Element::Range RangeOf(const Query& query, Field field);
+  static bool IsGiven(const Query& query, Field field);
+  uint32_t AddRow(const std::string& key);
+  /* false when the key has no row */
+  bool RemoveRow(const std::string& key, uint32_t* row);
+  void AddToField(Field field, const Record& record, uint32_t row);
+  Predicate MakePredicate(const Query& query, Field field) const;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SECONDARY_INDEX_H_
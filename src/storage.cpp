@@ -1,23 +1,25 @@
+#include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <utility>
 #include <iostream>
+#include <mutex>
 #include "storage.h"
+#include "string_pool.h"
 
 namespace s21 {
 
 Storage::Element::Element()
-  : key_(""), data_() {}
+  : key_(""), record_() {}
 
-Storage::Element::Element(string key, const Data& data)
-  : key_(key), data_(data) {}
+Storage::Element::Element(std::string key, const Data& data)
+  : key_(std::move(key)), record_(Encode(data)) {}
 
 Storage::Element::Element(const Element& other)
-  : key_(other.key_), data_(other.data_) {}
+  : key_(other.key_), record_(other.record_) {}
 
-Storage::Element::Element(Element&& other) {
-  std::swap(key_, other.key_);
-  std::swap(data_, other.data_);
-}
+Storage::Element::Element(Element&& other) noexcept
+  : key_(std::move(other.key_)), record_(other.record_) {}
 
 Storage::Element::~Element() {}
 
@@ -38,7 +40,7 @@ bool Storage::Element::operator!=(const Element& other) {
 }
 
 void Storage::Element::operator=(const Data &data) {
-  data_ = data;
+  record_ = Encode(data);
 }
 
 bool Storage::Element::operator>=(const Element& other) {
@@ -51,97 +53,242 @@ bool Storage::Element::operator<=(const Element& other) {
 
 Storage::Element& Storage::Element::operator=(const Element& other) {
   key_ = other.key_;
-  data_ = other.data_;
+  record_ = other.record_;
   return *this;
 }
 
-Storage::Element& Storage::Element::operator=(const Element&& other) {
-  key_ = other.key_;
-  data_ = other.data_;
+Storage::Element& Storage::Element::operator=(Element&& other) noexcept {
+  key_ = std::move(other.key_);
+  record_ = other.record_;
   return *this;
 }
 
-Storage::Element::Data& Storage::Element::operator*() {
-  return data_;
+Storage::Element::Record& Storage::Element::operator*() {
+  return record_;
 }
 
-const std::string Storage::Element::GetKey() const {
+const std::string& Storage::Element::GetKey() const {
   return key_;
 }
 
 Storage::Element::Data Storage::Element::GetData() const {
-  return data_;
+  return {GetSurname(), GetName(), record_.year_of_birth, GetCity(), record_.coins, record_.life_time};
+}
+
+const Storage::Element::Record& Storage::Element::GetRecord() const {
+  return record_;
 }
 
-std::string Storage::Element::GetSurname() {
-  return data_.surname;
+const std::string& Storage::Element::GetSurname() const {
+  return StringPool::Get(record_.surname);
 }
 
-std::string Storage::Element::GetName() {
-  return data_.name;
+const std::string& Storage::Element::GetName() const {
+  return StringPool::Get(record_.name);
 }
 
-std::string Storage::Element::GetYearOfBirth() {
-  return data_.year_of_birth;
+int32_t Storage::Element::GetYearOfBirth() const {
+  return record_.year_of_birth;
 }
-std::string Storage::Element::GetCity() {
-  return data_.city;
+const std::string& Storage::Element::GetCity() const {
+  return StringPool::Get(record_.city);
 }
 
-std::string Storage::Element::GetCoins() {
-  return data_.coins;
+int32_t Storage::Element::GetCoins() const {
+  return record_.coins;
 }
 
-int Storage::Element::GetLifeTime() {
-  return data_.life_time;
+int Storage::Element::GetLifeTime() const {
+  return record_.life_time;
 }
 
 void Storage::Element::SetKey(string key) {
   key_ = key;
 }
 void Storage::Element::SetData(const Data& data) {
-  data_ = data;
+  record_ = Encode(data);
 }
 
 void Storage::Element::SetSurname(string surname) {
-  data_.surname = surname;
+  record_.surname = StringPool::Intern(surname);
 }
 
 void Storage::Element::SetName(string name) {
-  data_.name = name;
+  record_.name = StringPool::Intern(name);
 }
 
-void Storage::Element::SetYearOfBirth(string year_of_birth) {
-  data_.year_of_birth = year_of_birth;
+void Storage::Element::SetYearOfBirth(int32_t year_of_birth) {
+  record_.year_of_birth = year_of_birth;
 }
 
 void Storage::Element::SetCity(string city) {
-  data_.city = city;
+  record_.city = StringPool::Intern(city);
 }
 
-void Storage::Element::SetCoins(string coins) {
-  data_.coins = coins;
+void Storage::Element::SetCoins(int32_t coins) {
+  record_.coins = coins;
+}
+
+void Storage::Element::UpdateData(const Data& data) {
+  if (!Data::IsAny(data.surname)) SetSurname(data.surname);
+  if (!Data::IsAny(data.name)) SetName(data.name);
+  if (!Data::IsAny(data.year_of_birth)) record_.year_of_birth = data.year_of_birth;
+  if (!Data::IsAny(data.city)) SetCity(data.city);
+  if (!Data::IsAny(data.coins)) record_.coins = data.coins;
 }
 
 void Storage::Element::PrintElement() const {
-  std::cout <<"key = " << key_ << "; " << data_.surname << "; " << data_.name << "; " << data_.year_of_birth
-            << "; " << data_.city << "; " << data_.coins << std::endl;
+  std::cout <<"key = " << key_ << "; " << GetSurname() << "; " << GetName() << "; "
+            << record_.year_of_birth << "; " << GetCity() << "; " << record_.coins << std::endl;
 }
 
-Storage::vector Storage::Keys() {
-  vector vector_of_keys;
-  std::vector<Storage::Element> vector_of_elements = AllElements();
-  for (auto element : vector_of_elements) {
-    vector_of_keys.push_back(element.GetKey());
+Storage::Element::Record Storage::Element::Encode(const Data& data) {
+  return {StringPool::Intern(data.surname), StringPool::Intern(data.name), StringPool::Intern(data.city),
+          data.year_of_birth, data.coins, data.life_time};
+}
+
+namespace {
+
+Storage::Element::Range RangeOf(int32_t value) {
+  if (Storage::Element::Data::IsAny(value)) return {};
+  return {value, value};
+}
+
+}  // namespace
+
+Storage::Element::Query Storage::Element::EncodeQuery(const Data& data) {
+  return {StringPool::Find(data.surname), StringPool::Find(data.name), StringPool::Find(data.city),
+          RangeOf(data.year_of_birth), RangeOf(data.coins)};
+}
+
+bool Storage::Element::IsInlineKey(const std::string& key) {
+  static const size_t kInlineLength = std::string().capacity();
+  return key.size() <= kInlineLength;
+}
+
+std::vector<Storage::Part> Storage::Split(size_t) const {
+  return {[this](const Visitor& visitor) { ForEach(visitor); }};
+}
+
+size_t Storage::PartsFor(size_t records, size_t parts) {
+  return std::max<size_t>(1, std::min(parts, records / kMinPartSize));
+}
+
+namespace {
+
+size_t ReverseBits(size_t value) {
+  size_t result = 0;
+  for (size_t bit = 0; bit < sizeof(value) * 8; ++bit, value >>= 1) result = (result << 1) | (value & 1);
+  return result;
+}
+
+}  // namespace
+
+size_t Storage::NextBucket(size_t cursor, size_t mask) {
+  return ReverseBits(ReverseBits(cursor | ~mask) + 1);
+}
+
+size_t Storage::ParseCursor(const std::string& cursor) {
+  size_t parsed = 0;
+  size_t position = 0;
+  try {
+    parsed = std::stoull(cursor, &position);
+  } catch (const std::exception&) {
+    throw std::invalid_argument("invalid cursor");
+  }
+  if (position != cursor.size() || cursor[0] == '-') throw std::invalid_argument("invalid cursor");
+  return parsed;
+}
+
+std::string Storage::ScanFrom(const std::string& cursor, string prefix, bool* is_after) {
+  *is_after = false;
+  if (cursor == "0") return prefix;
+  if (cursor.empty() || cursor[0] != '>') throw std::invalid_argument("invalid cursor");
+  std::string key = cursor.substr(1);
+  if (key < prefix) return prefix;
+  *is_after = true;
+  return key;
+}
+
+std::string Storage::OrderedCursor(string key) {
+  return ">" + key;
+}
+
+bool Storage::HasPrefix(string key, string prefix) {
+  return key.compare(0, prefix.size(), prefix) == 0;
+}
+
+/* a star first matches nothing, on a mismatch the last star takes one more
+   character and the rest is tried again */
+bool Storage::IsKeyMatch(string pattern, string key) {
+  size_t p = 0;
+  size_t k = 0;
+  size_t star = std::string::npos;
+  size_t star_key = 0;
+  while (k < key.size()) {
+    if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_key = k;
+    } else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == key[k])) {
+      ++p;
+      ++k;
+    } else if (star != std::string::npos) {
+      p = star + 1;
+      k = ++star_key;
+    } else {
+      return false;
+    }
   }
-  return vector_of_keys;
+  while (p < pattern.size() && pattern[p] == '*') ++p;
+  return p == pattern.size();
+}
+
+std::string Storage::LiteralPrefix(string pattern) {
+  return pattern.substr(0, pattern.find_first_of("*?"));
+}
+
+Storage::vector Storage::Keys() {
+  auto pieces = ScanParts<vector>([](const Element& element, vector* keys) {
+    keys->push_back(element.GetKey());
+  });
+  return Join(&pieces);
 }
 
 std::vector<Storage::Element::Data> Storage::ShowAll() {
-  std::vector<Storage::Element::Data> vector_of_datas;
-  std::vector<Storage::Element> vector_of_elements = AllElements();
-  for (auto element : vector_of_elements) vector_of_datas.push_back(element.GetData());
-  return vector_of_datas;
+  auto pieces = ScanParts<std::vector<Element::Data>>([](const Element& element, std::vector<Element::Data>* datas) {
+    datas->push_back(element.GetData());
+  });
+  return Join(&pieces);
+}
+
+Storage::vector Storage::Find(const Element::Data& data) const {
+  return Find(Element::EncodeQuery(data));
+}
+
+Storage::vector Storage::Find(const Element::Query& query, size_t* examined) const {
+  struct Piece {
+    vector keys;
+    size_t examined = 0;
+  };
+  auto pieces = ScanParts<Piece>([&query](const Element& element, Piece* piece) {
+    ++piece->examined;
+    if (IsDataSiutable(query, element.GetRecord())) piece->keys.push_back(element.GetKey());
+  });
+  std::vector<vector> keys;
+  keys.reserve(pieces.size());
+  if (examined) *examined = 0;
+  for (auto& piece : pieces) {
+    if (examined) *examined += piece.examined;
+    keys.push_back(std::move(piece.keys));
+  }
+  return Join(&keys);
+}
+
+std::vector<Storage::Element> Storage::AllElements() const {
+  auto pieces = ScanParts<std::vector<Element>>([](const Element& element, std::vector<Element>* elements) {
+    elements->push_back(element);
+  });
+  return Join(&pieces);
 }
 
 int Storage::Upload(string file_name) {
@@ -163,29 +310,56 @@ bool Storage::CheckFileType(string file_name) {
   return true;
 }
 
+/* a bad line stops the upload, the lines before it stay loaded */
 int Storage::FillElementsFromFile(std::ifstream* input) {
   std::string line;
   int counter = 0;
-  while (std::getline(*input, line)) {
-    std::istringstream iss(line);
-    Element::Data data;
-    std::string key;
-    int year_of_birth, coins;
-    if (!(iss >> key >> data.surname >> data.name >> year_of_birth >> data.city >> coins)) {
-      throw std::invalid_argument("invalid data");
+  const bool is_bulk = IsBulkLoaded();
+  std::vector<Element> elements;
+  try {
+    while (std::getline(*input, line)) {
+      std::istringstream iss(line);
+      Element::Data data;
+      std::string key;
+      if (!(iss >> key >> data.surname >> data.name >> data.year_of_birth >> data.city >> data.coins)) {
+        throw std::invalid_argument("invalid data");
+      }
+      if (data.year_of_birth < 0 || data.coins < 0) throw std::invalid_argument("years or coins are negative");
+      const int kDefault_life_time = -1;
+      data.life_time = kDefault_life_time;
+      if (is_bulk) {
+        elements.emplace_back(std::move(key), data);
+      } else {
+        Set(Element(std::move(key), data));
+      }
+      ++counter;
     }
-    if (year_of_birth  < 0 || coins < 0) throw std::invalid_argument("years or coins are negative");
-    data.year_of_birth = std::to_string(year_of_birth);
-    data.coins = std::to_string(coins);
-    const int kDefault_life_time = -1;
-    data.life_time = kDefault_life_time;
-    Element element = Element(key, data);
-    Set(element);
-    ++counter;
+  } catch (...) {
+    Load(&elements);
+    throw;
   }
+  Load(&elements);
   return counter;
 }
 
+bool Storage::IsBulkLoaded() const {
+  return false;
+}
+
+void Storage::Load(std::vector<Element>* elements) {
+  for (auto& element : *elements) Set(std::move(element));
+}
+
+/* a file exported by an ordered engine is sorted already */
+void Storage::SortByKey(std::vector<Element>* elements) {
+  auto is_less = [](const Element& left, const Element& right) { return left.GetKey() < right.GetKey(); };
+  if (!std::is_sorted(elements->begin(), elements->end(), is_less)) {
+    std::stable_sort(elements->begin(), elements->end(), is_less);
+  }
+  auto is_same = [](const Element& left, const Element& right) { return left.GetKey() == right.GetKey(); };
+  elements->erase(std::unique(elements->begin(), elements->end(), is_same), elements->end());
+}
+
 int Storage::Export(std::string file_name) {
   int counter = 0;
   if (!CheckFileType(file_name)) {
@@ -195,23 +369,65 @@ int Storage::Export(std::string file_name) {
     std::ofstream out;
     out.open(file_name, std::ios::trunc);
     if (!out.is_open()) throw std::invalid_argument("Export file error: file not exist or corrupted");
-    std::vector<Element> vector_of_elements = AllElements();
-    for (auto element : vector_of_elements) {
-      out << element.GetKey() << " " << element.GetSurname() << " "
-          << element.GetName() << " " << element.GetYearOfBirth() << " "
-          << element.GetCity() << " " << element.GetCoins() << "\n";
-      ++counter;
+    auto write = [](const Element& element, std::ostream* lines) {
+      *lines << element.GetKey() << " " << element.GetSurname() << " "
+             << element.GetName() << " " << element.GetYearOfBirth() << " "
+             << element.GetCity() << " " << element.GetCoins() << "\n";
+    };
+    std::vector<Part> parts = Split(kPartsPerThread * WorkPool::Instance().Threads());
+    if (parts.size() == 1) {
+      parts.front()([&out, &counter, &write](const Element& element) {
+        write(element, &out);
+        ++counter;
+      });
+      return counter;
     }
+    /* the lines of the parts are made in parallel; a part is written and
+       its lines freed as soon as the parts before it are written */
+    struct Piece {
+      std::stringstream lines;
+      int counter = 0;
+      bool is_done = false;
+    };
+    std::vector<Piece> pieces(parts.size());
+    std::mutex mutex;
+    size_t written = 0;
+    std::vector<WorkPool::Task> tasks;
+    tasks.reserve(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+      tasks.push_back([&parts, &pieces, &mutex, &written, &out, &counter, &write, i]() {
+        Piece* piece = &pieces[i];
+        parts[i]([piece, &write](const Element& element) {
+          write(element, &piece->lines);
+          ++piece->counter;
+        });
+        std::lock_guard lock(mutex);
+        piece->is_done = true;
+        for (; written < pieces.size() && pieces[written].is_done; ++written) {
+          /* an empty buffer would set the failbit of out */
+          if (pieces[written].counter > 0) out << pieces[written].lines.rdbuf();
+          counter += pieces[written].counter;
+          std::stringstream().swap(pieces[written].lines);
+        }
+      });
+    }
+    WorkPool::Instance().Run(&tasks);
   }
   return counter;
 }
 
-bool Storage::IsDataSiutable(const Element::Data &need_data, const Element::Data &exist_data) {
-  if ((need_data.surname != "-" && need_data.surname != exist_data.surname)
-    || (need_data.name != "-" && need_data.name != exist_data.name)
-    || (need_data.year_of_birth != "-" && need_data.year_of_birth != exist_data.year_of_birth)
-    || (need_data.city != "-" && need_data.city != exist_data.city)
-    || (need_data.coins!= "-" && need_data.coins != exist_data.coins)) {
+bool Storage::IsThreadSafe() const {
+  return false;
+}
+
+/* text fields are compared by their codes */
+bool Storage::IsDataSiutable(const Element::Query &need_data, const Element::Record &exist_data) {
+  const uint32_t kAnyCode = StringPool::kEmptyCode;
+  if (!need_data.year_of_birth.Contains(exist_data.year_of_birth)
+    || !need_data.coins.Contains(exist_data.coins)
+    || (need_data.surname != kAnyCode && need_data.surname != exist_data.surname)
+    || (need_data.name != kAnyCode && need_data.name != exist_data.name)
+    || (need_data.city != kAnyCode && need_data.city != exist_data.city)) {
     return false;
   }
   return true;
@@ -1,8 +1,14 @@
 #ifndef SRC_STORAGE_H_
 #define SRC_STORAGE_H_
 
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <utility>
 #include <vector>
+#include "work_pool.h"
 
 namespace s21 {
 
@@ -17,12 +23,30 @@ class Storage {
  public:
   class Element {
    public:
+    /* inclusive bounds of a number in FIND */
+    struct Range {
+      int32_t min = std::numeric_limits<int32_t>::min();
+      int32_t max = std::numeric_limits<int32_t>::max();
+      bool IsAll() const { return *this == Range(); }
+      bool Contains(int32_t value) const { return min <= value && value <= max; }
+      friend bool operator==(const Range& left, const Range& right) {
+        return left.min == right.min && left.max == right.max;
+      }
+    };
+
+    /* numbers are parsed and printed only by the command line and the file
+       import/export. In UPDATE and FIND an empty string or kAnyNumber stands
+       for a field that is left as it is or matches any value. */
     struct Data {
+      static constexpr int32_t kAnyNumber = std::numeric_limits<int32_t>::min();
+      static bool IsAny(const std::string& value) { return value.empty(); }
+      static bool IsAny(int32_t value) { return value == kAnyNumber; }
+
       std::string surname;
       std::string name;
-      std::string year_of_birth;
+      int32_t year_of_birth = 0;
       std::string city;
-      std::string coins;
+      int32_t coins = 0;
       int life_time = 0;
       friend bool operator==(const Data& data_left, const Data& data_right) {
         if (data_left.surname != data_right.surname ||
@@ -35,14 +59,37 @@ class Storage {
       void PrintData() const;
     };
 
+    /* what the engines keep: surname, name and city are codes of StringPool,
+       so a record takes no heap memory besides its key */
+    struct Record {
+      uint32_t surname = 0;
+      uint32_t name = 0;
+      uint32_t city = 0;
+      int32_t year_of_birth = 0;
+      int32_t coins = 0;
+      int life_time = 0;
+    };
+
+    /* FIND made of pool codes and ranges: code 0, the empty string, matches
+       anything and StringPool::kNoCode nothing */
+    struct Query {
+      uint32_t surname = 0;
+      uint32_t name = 0;
+      uint32_t city = 0;
+      Range year_of_birth;
+      Range coins;
+    };
+
     Element();
-    Element(string key, const Data& data);
+    Element(std::string key, const Data& data);
     Element(const Element& other);
-    Element(Element&& other);
+    /* moving takes the key over, a record lands in an engine without a
+       second copy of its key */
+    Element(Element&& other) noexcept;
     ~Element();
 
     Element& operator=(const Element& other);
-    Element& operator=(const Element&& other);
+    Element& operator=(Element&& other) noexcept;
     bool operator==(const Element& other);
     bool operator>(const Element& other);
     bool operator<(const Element& other);
@@ -50,53 +97,158 @@ class Storage {
     bool operator>=(const Element& other);
     bool operator<=(const Element& other);
     void operator=(const Data &data);
-    Data& operator*();
+    Record& operator*();
 
-    const std::string GetKey() const;
+    const std::string& GetKey() const;
+    /* decodes the record, the getters below do not copy the strings */
     Data GetData() const;
-    std::string GetSurname();
-    std::string GetName();
-    std::string GetYearOfBirth();
-    std::string GetCity();
-    std::string GetCoins();
-    int GetLifeTime();
+    const Record& GetRecord() const;
+    const std::string& GetSurname() const;
+    const std::string& GetName() const;
+    int32_t GetYearOfBirth() const;
+    const std::string& GetCity() const;
+    int32_t GetCoins() const;
+    int GetLifeTime() const;
 
     void SetKey(string key);
     void SetData(const Data& data);
     void SetSurname(string surname);
     void SetName(string name);
-    void SetYearOfBirth(string year_of_birth);
+    void SetYearOfBirth(int32_t year_of_birth);
     void SetCity(string city);
-    void SetCoins(string coins);
+    void SetCoins(int32_t coins);
+    /* sets the fields of data that are not wildcards */
+    void UpdateData(const Data& data);
     void PrintElement() const;
 
+    static Record Encode(const Data& data);
+    /* does not add new strings to the pool, they match no record. A number
+       becomes a range of one value, kAnyNumber the whole range. */
+    static Query EncodeQuery(const Data& data);
+    /* a key this short lives inside the std::string: an element that only
+       ever had such keys owns no heap memory and may be dropped without
+       its destructor */
+    static bool IsInlineKey(const std::string& key);
+
    private:
     std::string key_;
-    Data data_;
+    Record record_;
   };
 
+  /* borrows the record for the duration of the call, nothing is copied */
+  using Visitor = std::function<void(const Element&)>;
+  /* a piece of ForEach: the parts of a split walked one after another give
+     the records in the order of ForEach */
+  using Part = std::function<void(const Visitor&)>;
+  /* a step of SCAN goes on while the visitor returns true */
+  using ScanVisitor = std::function<bool(const Element&)>;
+
   Storage() = default;
   virtual ~Storage() = default;
 
   virtual void Set(element element) = 0;
+  virtual void Set(Element&& element) = 0;
   virtual Element Get(string key) const = 0;
+  virtual bool Visit(string key, const Visitor& visitor) const = 0;
+  /* calls the visitor for every record in the engine's own order */
+  virtual void ForEach(const Visitor& visitor) const = 0;
+  /* about the given number of parts for the parallel scans, the parts may
+     run at the same time; the whole ForEach by default */
+  virtual std::vector<Part> Split(size_t parts) const;
+  /* a step of a resumable walk: visits the records from the cursor on, "0"
+     at first, until the visitor returns false, a few more may follow, and
+     returns the cursor of the rest, "0" when nothing is left. A record that
+     stays from the first step to the last is visited at least once, however
+     the engine changes in between. Keys without the prefix may be skipped. */
+  virtual std::string Scan(const std::string& cursor, string prefix, const ScanVisitor& visitor) const = 0;
   virtual bool Exists(string key) const = 0;
   virtual bool Del(string key) = 0;
   virtual bool Update(string key, const Element::Data& data) = 0;
   vector Keys();
   virtual bool Rename(string key, string new_key) = 0;
   virtual int Ttl(string key) const = 0;
-  virtual vector Find(const Element::Data& data) const = 0;
+  virtual vector Find(const Element::Data& data) const;
+  /* counts the records it looked at when asked */
+  vector Find(const Element::Query& query, size_t* examined = nullptr) const;
   std::vector<Element::Data> ShowAll();
   int Upload(string file_name);
   int Export(std::string file_name);
   virtual void Init() = 0;
-  virtual std::vector<Element> AllElements() const  = 0;
+  virtual std::vector<Element> AllElements() const;
+  /* true when the engine synchronizes its own methods, Holder then calls it
+     with its lock shared */
+  virtual bool IsThreadSafe() const;
+  static bool IsDataSiutable(const Element::Query &need_data, const Element::Record &exist_data);
+  /* MATCH of SCAN: '*' matches any string, '?' any character */
+  static bool IsKeyMatch(string pattern, string key);
+  /* the pattern up to its first wildcard, every key it matches starts so */
+  static std::string LiteralPrefix(string pattern);
 
  protected:
-  static bool IsDataSiutable(const Element::Data &need_data, const Element::Data &exist_data);
+  /* a part of fewer records is not worth a task, a binary subtree of this
+     many levels is about that big */
+  static constexpr size_t kMinPartSize = 1024;
+  static constexpr size_t kMinPartDepth = 10;
+
+  /* parts of at least kMinPartSize records, no more than asked, at least one */
+  static size_t PartsFor(size_t records, size_t parts);
+
+  /* The cursor of a hash engine is a bucket with its bits reversed and
+     counted up from the high end: when the table doubles between two steps
+     a bucket splits into two the cursor has not reached yet, so no record
+     is skipped. The cursor of the next bucket of mask + 1, 0 after the last. */
+  static size_t NextBucket(size_t cursor, size_t mask);
+  static size_t ParseCursor(const std::string& cursor);
+  /* an ordered engine continues after the last key it visited, the cursor
+     is that key after '>'; the first step starts from the prefix */
+  static std::string ScanFrom(const std::string& cursor, string prefix, bool* is_after);
+  static std::string OrderedCursor(string key);
+  static bool HasPrefix(string key, string prefix);
+
+  /* true when UPLOAD should hand the records of a file over at once to
+     Load instead of setting them one by one as they are read */
+  virtual bool IsBulkLoaded() const;
+  /* the records of a file, or of its lines before a bad one, for the
+     engine empty after Init; a key met again is left as it was, as with
+     Set. Sets them one by one by default, a tree builds itself from them
+     sorted. */
+  virtual void Load(std::vector<Element>* elements);
+  /* sorts the records by key and drops the later ones of a key */
+  static void SortByKey(std::vector<Element>* elements);
 
  private:
+  /* parts per thread of the pool, so the threads can even out */
+  static constexpr size_t kPartsPerThread = 4;
+
+  /* every part of a split collects into its own piece on the work pool, the
+     pieces come back in the order of the parts */
+  template <typename Piece, typename Collect>
+  std::vector<Piece> ScanParts(const Collect& collect) const {
+    std::vector<Part> parts = Split(kPartsPerThread * WorkPool::Instance().Threads());
+    std::vector<Piece> pieces(parts.size());
+    std::vector<WorkPool::Task> tasks;
+    tasks.reserve(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+      tasks.push_back([&parts, &pieces, &collect, i]() {
+        Piece* piece = &pieces[i];
+        parts[i]([piece, &collect](const Element& element) { collect(element, piece); });
+      });
+    }
+    WorkPool::Instance().Run(&tasks);
+    return pieces;
+  }
+
+  template <typename T>
+  static std::vector<T> Join(std::vector<std::vector<T>>* pieces) {
+    if (pieces->size() == 1) return std::move(pieces->front());
+    size_t size = 0;
+    for (const auto& piece : *pieces) size += piece.size();
+    std::vector<T> result;
+    result.reserve(size);
+    for (auto& piece : *pieces) std::move(piece.begin(), piece.end(), std::back_inserter(result));
+    return result;
+  }
+
   bool CheckFileType(const std::string &file_name);
   int FillElementsFromFile(std::ifstream* input);
 };
@@ -0,0 +1,81 @@
+#include "string_pool.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace s21 {
+
+namespace {
+
+constexpr size_t kChunkBits = 10;
+constexpr size_t kChunkSize = size_t{1} << kChunkBits;
+constexpr size_t kMaxChunks = size_t{1} << 16;
+
+/* strings live in fixed chunks that never move, so the map can hold views
+   of them and a reader can index a chunk while a writer adds another one */
+struct Pool {
+  Pool() { Add(std::string()); }
+
+  uint32_t Add(const std::string& value) {
+    const size_t code = size.load(std::memory_order_relaxed);
+    if (code >> kChunkBits >= kMaxChunks) throw std::length_error("string pool is full");
+    std::atomic<std::string*>& chunk = chunks[code >> kChunkBits];
+    if (!chunk.load(std::memory_order_relaxed)) {
+      chunk.store(new std::string[kChunkSize], std::memory_order_release);
+    }
+    std::string& slot = chunk.load(std::memory_order_relaxed)[code & (kChunkSize - 1)];
+    slot = value;
+    codes.emplace(slot, code);
+    size.store(code + 1, std::memory_order_release);
+    return code;
+  }
+
+  std::shared_mutex mutex;
+  std::unordered_map<std::string_view, uint32_t> codes;
+  std::atomic<std::string*> chunks[kMaxChunks] = {};
+  std::atomic<size_t> size{0};
+};
+
+/* never destroyed: records of static storages may still be decoded while
+   the program exits */
+Pool& GetPool() {
+  static Pool* pool = new Pool;
+  return *pool;
+}
+
+}  // namespace
+
+uint32_t StringPool::Intern(const std::string& value) {
+  Pool& pool = GetPool();
+  {
+    std::shared_lock lock(pool.mutex);
+    auto it = pool.codes.find(value);
+    if (it != pool.codes.end()) return it->second;
+  }
+  std::unique_lock lock(pool.mutex);
+  auto it = pool.codes.find(value);
+  if (it != pool.codes.end()) return it->second;
+  return pool.Add(value);
+}
+
+uint32_t StringPool::Find(const std::string& value) {
+  Pool& pool = GetPool();
+  std::shared_lock lock(pool.mutex);
+  auto it = pool.codes.find(value);
+  return it == pool.codes.end() ? kNoCode : it->second;
+}
+
+const std::string& StringPool::Get(uint32_t code) {
+  const std::string* chunk = GetPool().chunks[code >> kChunkBits].load(std::memory_order_acquire);
+  return chunk[code & (kChunkSize - 1)];
+}
+
+size_t StringPool::Size() {
+  return GetPool().size.load(std::memory_order_acquire);
+}
+
+}  // namespace s21
@@ -0,0 +1,30 @@
+#ifndef SRC_STRING_POOL_H_
+#define SRC_STRING_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace s21 {
+
+/* One copy of every distinct surname, name and city, shared by all the
+   storages of the process. A record keeps 32-bit codes of its strings.
+   Strings are never freed, the fields are expected to have few distinct
+   values. Code 0 is the empty string. Decoding takes no lock, so records
+   can be read by lock-free readers. */
+class StringPool {
+ public:
+  static constexpr uint32_t kEmptyCode = 0;
+  static constexpr uint32_t kNoCode = UINT32_MAX;
+
+  /* the code of the value, the value is added when it is new */
+  static uint32_t Intern(const std::string& value);
+  /* the code of the value or kNoCode when no record ever had it */
+  static uint32_t Find(const std::string& value);
+  static const std::string& Get(uint32_t code);
+  static size_t Size();
+};
+
+}  // namespace s21
+
+#endif  // SRC_STRING_POOL_H_
@@ -1,7 +1,24 @@
 #include <set>
+#include <random>
+#include <map>
 #include <algorithm>
+#include <iomanip>
+#include <thread>
+#include <fstream>
+#include <cstdio>
+#include <atomic>
 #include "gtest/gtest.h"
+#include "allocation_counter.h"
+#include "string_pool.h"
+#include "secondary_index.h"
+#include "work_pool.h"
+#include "containers/arena.h"
+#include "containers/roaring_bitmap.h"
 #include "containers/hash_table.h"
+#include "containers/swiss_table.h"
+#include "containers/concurrent_hash_table.h"
+#include "containers/epoch.h"
+#include "holder.h"
 #include "containers/b_plus_tree.h"
 #include "containers/self_balancing_binary_search_tree.h"
 #include "storage.h"
@@ -11,6 +28,7 @@
 static s21::HashTable table = s21::HashTable();
 static s21::BPlusTree b_tree = s21::BPlusTree();
 static s21::SelfBalancingBinarySearchTree avl_tree = s21::SelfBalancingBinarySearchTree();
+static const int32_t kAny = s21::Storage::Element::Data::kAnyNumber;
 bool FirstVectorIncludesSecond(std::vector<s21::Storage::Element::Data> v1,
                     std::vector<s21::Storage::Element::Data> v2);
 
@@ -92,11 +110,11 @@ TEST(Transactions, hash_upload) {
   EXPECT_TRUE(set_of_keys_expected == set_of_result_b_tree);
 
   std::vector<s21::Storage::Element::Data> vector_of_elements_expect = {
-    {"A", "Aa", "1990", "Novos", "1", 1},
-    {"B", "Bb", "2002", "Berdsk", "2", 2},
-    {"C", "Cc", "23", "Ob", "3", 4},
-    {"D", "Dd", "87", "Inya", "4", 5},
-    {"E", "Ee", "566666", "Omsk", "5", 6}
+    {"A", "Aa", 1990, "Novos", 1, 1},
+    {"B", "Bb", 2002, "Berdsk", 2, 2},
+    {"C", "Cc", 23, "Ob", 3, 4},
+    {"D", "Dd", 87, "Inya", 4, 5},
+    {"E", "Ee", 566666, "Omsk", 5, 6}
   };
   std::vector<s21::Storage::Element::Data> vector_of_elements_result = table.ShowAll();
   std::vector<s21::Storage::Element::Data> vector_of_elements_result_b_tree = b_tree.ShowAll();
@@ -110,32 +128,32 @@ TEST(Transactions, hash_upload) {
 TEST(Transactions, hash_set) {
   table.Init();
   b_tree.Init();
-  s21::HashTable::data_t info1 = {"q1", "w1", "e1", "r1", "31", 1};
+  s21::HashTable::data_t info1 = {"q1", "w1", 1, "r1", 31, 1};
   s21::Storage::Element element1 = s21::Storage::Element("first", info1);
   table.Set(element1);
   b_tree.Set(element1);
 
-  s21::HashTable::data_t info2 = {"q2", "w2", "e2", "r2", "32", 2};
+  s21::HashTable::data_t info2 = {"q2", "w2", 2, "r2", 32, 2};
   s21::Storage::Element element2 = s21::Storage::Element("second", info2);
   table.Set(element2);
   b_tree.Set(element2);
 
-  s21::HashTable::data_t info3 = {"q3", "w3", "e3", "r3", "33", 3};
+  s21::HashTable::data_t info3 = {"q3", "w3", 3, "r3", 33, 3};
   s21::Storage::Element element3 = s21::Storage::Element("th", info3);
   table.Set(element3);
   b_tree.Set(element3);
 
-  s21::HashTable::data_t info4 = {"q3", "w3", "e3", "r3", "34", 4};
+  s21::HashTable::data_t info4 = {"q3", "w3", 3, "r3", 34, 4};
   s21::Storage::Element element4 = s21::Storage::Element("thoo", info4);
   table.Set(element4);
   b_tree.Set(element4);
 
-  s21::HashTable::data_t info5 = {"q4", "w4", "e3", "r3", "34", 5};
+  s21::HashTable::data_t info5 = {"q4", "w4", 3, "r3", 34, 5};
   s21::Storage::Element element5 = s21::Storage::Element("foo", info5);
   table.Set(element5);
   b_tree.Set(element5);
 
-  s21::HashTable::data_t info6 = {"q4", "w4", "e4", "r3", "34", 5};
+  s21::HashTable::data_t info6 = {"q4", "w4", 4, "r3", 34, 5};
   s21::Storage::Element element6 = s21::Storage::Element("foo1", info6);
   table.Set(element6);
   b_tree.Set(element6);
@@ -143,7 +161,7 @@ TEST(Transactions, hash_set) {
 
 TEST(Transactions, hash_get_exit_del_ttl) {
   /*--------get----------*/
-  s21::HashTable::data_t info4 = {"q3", "w3", "e3", "r3", "34", 4};
+  s21::HashTable::data_t info4 = {"q3", "w3", 3, "r3", 34, 4};
   s21::Storage::Element element4 = s21::Storage::Element("thoo", info4);
   s21::Storage::Element el_result1 = table.Get("thoo");
   EXPECT_TRUE(element4 == el_result1);
@@ -227,10 +245,10 @@ TEST(Transactions, hash_keys) {
 }
 
 TEST(Transactions, hash_update) {
-  s21::HashTable::data_t info_update = {"q_new", "-", "e2", "-", "32_new", 2999};
+  s21::HashTable::data_t info_update = {"q_new", "", 2, "", 320, 2999};
   table.Update("second_rename", info_update);
   s21::Storage::Element el_result3 = table.Get("second_rename");
-  s21::HashTable::data_t info_update_expect = {"q_new", "w2", "e2", "r2", "32_new", 2};
+  s21::HashTable::data_t info_update_expect = {"q_new", "w2", 2, "r2", 320, 2};
   EXPECT_EQ(info_update_expect, el_result3.GetData());
 
   b_tree.Update("second_rename", info_update);
@@ -239,7 +257,7 @@ TEST(Transactions, hash_update) {
 }
 
 TEST(Transactions, hash_find) {
-  s21::HashTable::data_t info = {"-", "-", "-", "r3", "-"};
+  s21::HashTable::data_t info = {"", "", kAny, "r3", kAny};
   s21::Storage::vector vector_of_keys_expected = {"thoo", "foo", "foo1"};
   s21::Storage::vector vector_of_keys_result = table.Find(info);
   EXPECT_EQ(vector_of_keys_expected.size(), vector_of_keys_result.size());
@@ -248,7 +266,7 @@ TEST(Transactions, hash_find) {
   std::set<std::string> set_of_keys_result(vector_of_keys_result.begin(), vector_of_keys_result.end());
   EXPECT_EQ(set_of_keys_expected, set_of_keys_result);
 
-  s21::HashTable::data_t info1 = {"-", "-", "-", "-", "32_new"};
+  s21::HashTable::data_t info1 = {"", "", kAny, "", 320};
   s21::Storage::vector vector_of_keys_result1 = table.Find(info1);
   EXPECT_EQ(1, vector_of_keys_result1.size());
   EXPECT_EQ(vector_of_keys_result1[0], "second_rename");
@@ -267,11 +285,11 @@ TEST(Transactions, hash_find) {
 
 TEST(Transactions, hash_showall) {
   std::vector<s21::Storage::Element::Data> vector_of_elements_expect = {
-    {"q1", "w1", "e1", "r1", "31", 1},
-    {"q_new", "w2", "e2", "r2", "32_new", 2},
-    {"q3", "w3", "e3", "r3", "34", 4},
-    {"q4", "w4", "e3", "r3", "34", 5},
-    {"q4", "w4", "e4", "r3", "34", 5}
+    {"q1", "w1", 1, "r1", 31, 1},
+    {"q_new", "w2", 2, "r2", 320, 2},
+    {"q3", "w3", 3, "r3", 34, 4},
+    {"q4", "w4", 3, "r3", 34, 5},
+    {"q4", "w4", 4, "r3", 34, 5}
   };
   std::vector<s21::Storage::Element::Data> vector_of_elements_result = table.ShowAll();
   EXPECT_TRUE(FirstVectorIncludesSecond(vector_of_elements_result, vector_of_elements_expect));
@@ -282,48 +300,48 @@ TEST(Transactions, hash_showall) {
   EXPECT_TRUE(FirstVectorIncludesSecond(vector_of_elements_expect, vector_result_b_tree));
 
   std::vector<s21::Storage::Element::Data> vector_of_elements_not_expect = {
-    {"q1", "w1", "e1", "r1", "31", 1},
-    {"q_new", "w2", "e2", "r2", "32_new", 2},
-    {"q3", "w3", "e3", "r3", "34", 4},
-    {"q4", "w4", "e3", "r3", "34", 5}
+    {"q1", "w1", 1, "r1", 31, 1},
+    {"q_new", "w2", 2, "r2", 320, 2},
+    {"q3", "w3", 3, "r3", 34, 4},
+    {"q4", "w4", 3, "r3", 34, 5}
   };
   EXPECT_TRUE(!FirstVectorIncludesSecond(vector_of_elements_not_expect, vector_result_b_tree));
 }
 
 TEST(Transactions, hash_export) {
   table.Init();
-  s21::HashTable::data_t info1 = {"q1", "w1", "1", "r1", "31", 1};
+  s21::HashTable::data_t info1 = {"q1", "w1", 1, "r1", 31, 1};
   s21::Storage::Element element1 = s21::Storage::Element("first", info1);
   table.Set(element1);
 
-  s21::HashTable::data_t info2 = {"q2", "w2", "2", "r2", "32", 2};
+  s21::HashTable::data_t info2 = {"q2", "w2", 2, "r2", 32, 2};
   s21::Storage::Element element2 = s21::Storage::Element("second", info2);
   table.Set(element2);
 
-  s21::HashTable::data_t info3 = {"q3", "w3", "3", "r3", "33", 3};
+  s21::HashTable::data_t info3 = {"q3", "w3", 3, "r3", 33, 3};
   s21::Storage::Element element3 = s21::Storage::Element("th", info3);
   table.Set(element3);
 
-  s21::HashTable::data_t info4 = {"q3", "w3", "3", "r3", "34", 4};
+  s21::HashTable::data_t info4 = {"q3", "w3", 3, "r3", 34, 4};
   s21::Storage::Element element4 = s21::Storage::Element("thoo", info4);
   table.Set(element4);
 
-  s21::HashTable::data_t info5 = {"q4", "w4", "3", "r3", "34", 5};
+  s21::HashTable::data_t info5 = {"q4", "w4", 3, "r3", 34, 5};
   s21::Storage::Element element5 = s21::Storage::Element("foo", info5);
   table.Set(element5);
 
-  s21::HashTable::data_t info6 = {"q4", "w4", "4", "r3", "34", 5};
+  s21::HashTable::data_t info6 = {"q4", "w4", 4, "r3", 34, 5};
   s21::Storage::Element element6 = s21::Storage::Element("foo1", info6);
   table.Set(element6);
   table.Export("sources/test_export.data");
   table.Upload("sources/test_export.data");
   std::vector<s21::Storage::Element::Data> vector_of_elements_expect = {
-    {"q1", "w1", "1", "r1", "31", 1},
-    {"q2", "w2", "2", "r2", "32", 2},
-    {"q3", "w3", "3", "r3", "33", 3},
-    {"q3", "w3", "3", "r3", "34", 4},
-    {"q4", "w4", "3", "r3", "34", 5},
-    {"q4", "w4", "4", "r3", "34", 5}
+    {"q1", "w1", 1, "r1", 31, 1},
+    {"q2", "w2", 2, "r2", 32, 2},
+    {"q3", "w3", 3, "r3", 33, 3},
+    {"q3", "w3", 3, "r3", 34, 4},
+    {"q4", "w4", 3, "r3", 34, 5},
+    {"q4", "w4", 4, "r3", 34, 5}
   };
   std::vector<s21::Storage::Element::Data> vector_of_elements_result = table.ShowAll();
   EXPECT_TRUE(FirstVectorIncludesSecond(vector_of_elements_result, vector_of_elements_expect));
@@ -349,15 +367,15 @@ TEST(Transactions, hash_export) {
 /* -------------------------------------------------------------------------- */
 
 std::vector<s21::Storage::Element> elements = {
-  {"key1", {"surname_1", "name_1", "1999", "City_1", "15", 0}},
-  {"key2", {"surname_2", "name_2", "2001", "City_1", "25", 0}},
-  {"key3", {"surname_3", "name_3", "2001", "City_3", "35", 0}},
-  {"key4", {"surname_4", "name_1", "2005", "City_3", "45", 0}},
-  {"key5", {"surname_5", "name_2", "1990", "City_4", "0", 0}},
-  {"key6", {"surname_6", "name_3", "1997", "City_5", "15", 0}},
-  {"key7", {"surname_7", "name_1", "1998", "City_2", "15", 0}},
-  {"key8", {"surname_8", "name_2", "1989", "City_6", "5", 0}},
-  {"key9", {"surname_9", "name_3", "1999", "City_1", "5", 0}}
+  {"key1", {"surname_1", "name_1", 1999, "City_1", 15, 0}},
+  {"key2", {"surname_2", "name_2", 2001, "City_1", 25, 0}},
+  {"key3", {"surname_3", "name_3", 2001, "City_3", 35, 0}},
+  {"key4", {"surname_4", "name_1", 2005, "City_3", 45, 0}},
+  {"key5", {"surname_5", "name_2", 1990, "City_4", 0, 0}},
+  {"key6", {"surname_6", "name_3", 1997, "City_5", 15, 0}},
+  {"key7", {"surname_7", "name_1", 1998, "City_2", 15, 0}},
+  {"key8", {"surname_8", "name_2", 1989, "City_6", 5, 0}},
+  {"key9", {"surname_9", "name_3", 1999, "City_1", 5, 0}}
 };
 
 TEST(Transactions, avl_move_copy) {
@@ -495,7 +513,7 @@ TEST(Transactions, update) {
   }
 
   ASSERT_TRUE(
-  AVL.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", "2005", "City_3", "45", 0}));
+  AVL.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", 2005, "City_3", 45, 0}));
   auto result = AVL.Get("key4");
   ASSERT_EQ(result.GetSurname(), "change_1");
   ASSERT_EQ(result.GetYearOfBirth(), elements[3].GetYearOfBirth());
@@ -504,7 +522,7 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[3].GetCoins());
 
   ASSERT_TRUE(
-  AVL.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", "1989", "change_2", "5", 0}));
+  AVL.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", 1989, "change_2", 5, 0}));
   result = AVL.Get("key8");
   ASSERT_EQ(result.GetSurname(), elements[7].GetSurname());
   ASSERT_EQ(result.GetYearOfBirth(), elements[7].GetYearOfBirth());
@@ -513,16 +531,16 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[7].GetCoins());
 
   ASSERT_TRUE(
-  AVL.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", "2022", "City_1", "25", 0}));
+  AVL.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", 2022, "City_1", 25, 0}));
   result = AVL.Get("key2");
   ASSERT_EQ(result.GetSurname(), elements[1].GetSurname());
-  ASSERT_EQ(result.GetYearOfBirth(), "2022");
+  ASSERT_EQ(result.GetYearOfBirth(), 2022);
   ASSERT_EQ(result.GetName(), elements[1].GetName());
   ASSERT_EQ(result.GetCity(), elements[1].GetCity());
   ASSERT_EQ(result.GetCoins(), elements[1].GetCoins());
 
   ASSERT_TRUE(
-  hash_table.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", "2005", "City_3", "45", 0}));
+  hash_table.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", 2005, "City_3", 45, 0}));
   result = hash_table.Get("key4");
   ASSERT_EQ(result.GetSurname(), "change_1");
   ASSERT_EQ(result.GetYearOfBirth(), elements[3].GetYearOfBirth());
@@ -531,7 +549,7 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[3].GetCoins());
 
   ASSERT_TRUE(
-  hash_table.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", "1989", "change_2", "5", 0}));
+  hash_table.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", 1989, "change_2", 5, 0}));
   result = hash_table.Get("key8");
   ASSERT_EQ(result.GetSurname(), elements[7].GetSurname());
   ASSERT_EQ(result.GetYearOfBirth(), elements[7].GetYearOfBirth());
@@ -540,16 +558,16 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[7].GetCoins());
 
   ASSERT_TRUE(
-  hash_table.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", "2022", "City_1", "25", 0}));
+  hash_table.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", 2022, "City_1", 25, 0}));
   result = hash_table.Get("key2");
   ASSERT_EQ(result.GetSurname(), elements[1].GetSurname());
-  ASSERT_EQ(result.GetYearOfBirth(), "2022");
+  ASSERT_EQ(result.GetYearOfBirth(), 2022);
   ASSERT_EQ(result.GetName(), elements[1].GetName());
   ASSERT_EQ(result.GetCity(), elements[1].GetCity());
   ASSERT_EQ(result.GetCoins(), elements[1].GetCoins());
 
   ASSERT_TRUE(
-  b_treee.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", "2005", "City_3", "45", 0}));
+  b_treee.Update("key4", s21::Storage::Element::Data{"change_1", "name_1", 2005, "City_3", 45, 0}));
   result = b_treee.Get("key4");
   ASSERT_EQ(result.GetSurname(), "change_1");
   ASSERT_EQ(result.GetYearOfBirth(), elements[3].GetYearOfBirth());
@@ -558,7 +576,7 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[3].GetCoins());
 
   ASSERT_TRUE(
-  b_treee.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", "1989", "change_2", "5", 0}));
+  b_treee.Update("key8", s21::Storage::Element::Data{"surname_8", "name_2", 1989, "change_2", 5, 0}));
   result = b_treee.Get("key8");
   ASSERT_EQ(result.GetSurname(), elements[7].GetSurname());
   ASSERT_EQ(result.GetYearOfBirth(), elements[7].GetYearOfBirth());
@@ -567,10 +585,10 @@ TEST(Transactions, update) {
   ASSERT_EQ(result.GetCoins(), elements[7].GetCoins());
 
   ASSERT_TRUE(
-  b_treee.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", "2022", "City_1", "25", 0}));
+  b_treee.Update("key2", s21::Storage::Element::Data{"surname_2", "name_2", 2022, "City_1", 25, 0}));
   result = b_treee.Get("key2");
   ASSERT_EQ(result.GetSurname(), elements[1].GetSurname());
-  ASSERT_EQ(result.GetYearOfBirth(), "2022");
+  ASSERT_EQ(result.GetYearOfBirth(), 2022);
   ASSERT_EQ(result.GetName(), elements[1].GetName());
   ASSERT_EQ(result.GetCity(), elements[1].GetCity());
   ASSERT_EQ(result.GetCoins(), elements[1].GetCoins());
@@ -648,6 +666,41 @@ TEST(Transactions, rename) {
   ASSERT_EQ(elements[2].GetData(), b_treee.Get("key10").GetData());
 }
 
+TEST(Transactions, rename_relinks_records) {
+  s21::SelfBalancingBinarySearchTree AVL;
+  s21::HashTable hash_table;
+  s21::BPlusTree b_treee;
+  s21::SwissTable swiss_table;
+  s21::ConcurrentHashTable concurrent_table;
+  std::vector<s21::Storage*> storages = {&AVL, &hash_table, &b_treee, &swiss_table, &concurrent_table};
+  for (auto storage : storages) {
+    std::map<std::string, std::string> records;
+    for (int i = 0; i < 300; ++i) {
+      const std::string key = "key" + std::to_string(i * 7 % 300);
+      storage->Set({key, {"surname_" + key, "n", 1990, "c", i, -1}});
+      records[key] = "surname_" + key;
+    }
+    ASSERT_FALSE(storage->Rename("key1", "key2"));
+    ASSERT_FALSE(storage->Rename("unknown", "key_new"));
+    ASSERT_TRUE(storage->Rename("key5", "key5"));
+    for (int i = 0; i < 600; ++i) {
+      auto it = records.begin();
+      std::advance(it, i * 13 % records.size());
+      /* a suffix keeps most keys between the same neighbours, a prefix
+         moves them to another part of the tree */
+      const std::string new_key = (i % 2 == 0) ? it->first + "a" : "z" + it->first;
+      if (records.count(new_key)) continue;
+      ASSERT_TRUE(storage->Rename(it->first, new_key));
+      records[new_key] = it->second;
+      records.erase(it);
+    }
+    ASSERT_EQ(storage->Keys().size(), records.size());
+    for (auto& record : records) {
+      ASSERT_EQ(storage->Get(record.first).GetSurname(), record.second);
+    }
+  }
+}
+
 TEST(Transactions, showall) {
   s21::SelfBalancingBinarySearchTree AVL;
   s21::HashTable hash_table;
@@ -688,12 +741,13 @@ TEST(Transactions, find) {
     b_treee.Set(elements[i]);
   }
 
-  auto result_a = AVL.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "-", 0});
-  auto result_h = hash_table.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "-", 0});
-  auto result_b = b_treee.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "-", 0});
+  auto result_a = AVL.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", kAny, 0});
+  auto result_h = hash_table.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", kAny, 0});
+  auto result_b = b_treee.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", kAny, 0});
   std::vector<std::string> expect = {"key4", "key1", "key7"};
   std::vector<std::string> expect_h = {"key1", "key4", "key7"};
-  std::vector<std::string> expect_b = {"key4", "key1", "key7"};
+  /* the B+ tree keeps its records in key order */
+  std::vector<std::string> expect_b = {"key1", "key4", "key7"};
 
   for (size_t k = 0; k < result_a.size(); ++k) {
     ASSERT_EQ(expect[k], result_a[k]);
@@ -701,9 +755,9 @@ TEST(Transactions, find) {
     ASSERT_EQ(expect_b[k], result_b[k]);
   }
 
-  result_a = AVL.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "15", 0});
-  result_h = hash_table.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "15", 0});
-  result_b = b_treee.Find(s21::Storage::Element::Data{"-", "name_1", "-", "-", "15", 0});
+  result_a = AVL.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", 15, 0});
+  result_h = hash_table.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", 15, 0});
+  result_b = b_treee.Find(s21::Storage::Element::Data{"", "name_1", kAny, "", 15, 0});
   expect = { "key1", "key7"};
 
   for (size_t k = 0; k < result_a.size(); ++k) {
@@ -712,9 +766,9 @@ TEST(Transactions, find) {
     ASSERT_EQ(expect[k], result_b[k]);
   }
 
-  result_a = AVL.Find(s21::Storage::Element::Data{"-", "-", "1999", "-", "-", 0});
-  result_h = hash_table.Find(s21::Storage::Element::Data{"-", "-", "1999", "-", "-", 0});
-  result_b = b_treee.Find(s21::Storage::Element::Data{"-", "-", "1999", "-", "-", 0});
+  result_a = AVL.Find(s21::Storage::Element::Data{"", "", 1999, "", kAny, 0});
+  result_h = hash_table.Find(s21::Storage::Element::Data{"", "", 1999, "", kAny, 0});
+  result_b = b_treee.Find(s21::Storage::Element::Data{"", "", 1999, "", kAny, 0});
   expect = { "key1", "key9"};
 
   for (size_t k = 0; k < result_a.size(); ++k) {
@@ -723,16 +777,16 @@ TEST(Transactions, find) {
     ASSERT_EQ(expect[k], result_b[k]);
   }
 
-  result_a = AVL.Find(s21::Storage::Element::Data{"-", "-", "-", "City_1", "-", 0});
-  result_h = hash_table.Find(s21::Storage::Element::Data{"-", "-", "-", "City_1", "-", 0});
-  result_b = b_treee.Find(s21::Storage::Element::Data{"-", "-", "-", "City_1", "-", 0});
+  result_a = AVL.Find(s21::Storage::Element::Data{"", "", kAny, "City_1", kAny, 0});
+  result_h = hash_table.Find(s21::Storage::Element::Data{"", "", kAny, "City_1", kAny, 0});
+  result_b = b_treee.Find(s21::Storage::Element::Data{"", "", kAny, "City_1", kAny, 0});
   expect = {"key2", "key1", "key9"};
   std::vector<std::string> expect_hash = {"key1", "key2", "key9"};
 
   for (size_t k = 0; k < result_a.size(); ++k) {
     ASSERT_EQ(expect[k], result_a[k]);
     ASSERT_EQ(expect_hash[k], result_h[k]);
-    ASSERT_EQ(expect[k], result_b[k]);
+    ASSERT_EQ(expect_hash[k], result_b[k]);
   }
 }
 
@@ -741,11 +795,11 @@ TEST(Transactions, ttl) {
   s21::HashTable hash_table;
   s21::BPlusTree b_treee;
   std::vector<s21::Storage::Element> time_element {
-    {{"tkey1"}, {"sname", "name", "2002", "City1", "10", 200}},
-    {{"tkey2"}, {"sname", "name", "2002", "City1", "10", 150}},
-    {{"key3"}, {"sname", "name", "2002", "City1", "10", -1}},
-    {{"key4"}, {"sname", "name", "2002", "City1", "10", -1}},
-    {{"tkey5"}, {"sname", "name", "2002", "City1", "10", 5000}}
+    {{"tkey1"}, {"sname", "name", 2002, "City1", 10, 200}},
+    {{"tkey2"}, {"sname", "name", 2002, "City1", 10, 150}},
+    {{"key3"}, {"sname", "name", 2002, "City1", 10, -1}},
+    {{"key4"}, {"sname", "name", 2002, "City1", 10, -1}},
+    {{"tkey5"}, {"sname", "name", 2002, "City1", 10, 5000}}
   };
 
   for (size_t i = 0; i < time_element.size(); ++i) {
@@ -766,6 +820,976 @@ TEST(Transactions, ttl) {
   ASSERT_EQ(b_treee.Ttl("tkey1"), 200);
 }
 
+TEST(Transactions, hash_growth) {
+  s21::HashTable hash_table;
+  const int count = 20000;
+  for (int i = 0; i < count; ++i) {
+    hash_table.Set({"key" + std::to_string(i), {"s", "n", i, "c", 1, -1}});
+  }
+  for (int i = 0; i < count; i += 2) {
+    ASSERT_TRUE(hash_table.Del("key" + std::to_string(i)));
+  }
+  for (int i = 1; i < count; i += 4) {
+    ASSERT_TRUE(hash_table.Rename("key" + std::to_string(i), "new" + std::to_string(i)));
+  }
+  ASSERT_FALSE(hash_table.Rename("key3", "key7"));
+  for (int i = 0; i < count; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    const std::string new_key = "new" + std::to_string(i);
+    bool is_renamed = i % 4 == 1;
+    ASSERT_EQ(hash_table.Exists(key), i % 2 == 1 && !is_renamed);
+    ASSERT_EQ(hash_table.Exists(new_key), is_renamed);
+    if (i % 2 == 1) {
+      ASSERT_EQ(hash_table.Get(is_renamed ? new_key : key).GetYearOfBirth(), i);
+    }
+  }
+  ASSERT_EQ(hash_table.Keys().size(), count / 2);
+}
+
+TEST(Transactions, hash_incremental_rehash) {
+  s21::HashTable hash_table;
+  std::set<std::string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    hash_table.Set({key, {"s", "n", 1, "c", 1, -1}});
+    keys.insert(key);
+    if (i % 3 == 0) {
+      ASSERT_TRUE(hash_table.Del(key));
+      keys.erase(key);
+    } else if (i % 3 == 1) {
+      ASSERT_TRUE(hash_table.Rename(key, "re" + key));
+      keys.erase(key);
+      keys.insert("re" + key);
+    }
+    for (auto& existing_key : keys) ASSERT_TRUE(hash_table.Exists(existing_key));
+  }
+  ASSERT_EQ(hash_table.Keys().size(), keys.size());
+}
+
+TEST(Transactions, swiss_table) {
+  s21::SwissTable swiss_table;
+  std::set<std::string> keys;
+  for (int i = 0; i < 5000; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    swiss_table.Set({key, {"s", "n", i, "c", 1, -1}});
+    keys.insert(key);
+    if (i % 3 == 0) {
+      ASSERT_TRUE(swiss_table.Del(key));
+      ASSERT_FALSE(swiss_table.Del(key));
+      keys.erase(key);
+    } else if (i % 3 == 1) {
+      ASSERT_TRUE(swiss_table.Rename(key, "re" + key));
+      keys.erase(key);
+      keys.insert("re" + key);
+    }
+  }
+  ASSERT_FALSE(swiss_table.Rename("key2", "rekey1"));
+  ASSERT_FALSE(swiss_table.Exists("key1"));
+  ASSERT_EQ(swiss_table.Get("rekey4").GetYearOfBirth(), 4);
+  ASSERT_TRUE(swiss_table.Update("key2", {"", "", kAny, "city", kAny, -1}));
+  ASSERT_EQ(swiss_table.Get("key2").GetCity(), "city");
+  ASSERT_EQ(swiss_table.Find({"", "", kAny, "city", kAny, -1}), std::vector<std::string>{"key2"});
+
+  s21::SwissTable copy(swiss_table);
+  s21::SwissTable moved(std::move(swiss_table));
+  for (auto storage : {&copy, &moved}) {
+    auto all_keys = storage->Keys();
+    ASSERT_EQ(std::set<std::string>(all_keys.begin(), all_keys.end()), keys);
+    for (auto& key : keys) ASSERT_TRUE(storage->Exists(key));
+  }
+  ASSERT_LE(keys.size() * 8, copy.Capacity() * 7);
+  ASSERT_EQ(swiss_table.Keys().size(), 0);
+}
+
+TEST(Transactions, concurrent_hash_table) {
+  s21::Holder holder(s21::Holder::StorageType::kConcurrentHashTable);
+  const int threads_count = 8;
+  const int count = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_count; ++t) {
+    threads.emplace_back([&holder, t]() {
+      for (int i = 0; i < count; ++i) {
+        const std::string key = std::to_string(t) + "_" + std::to_string(i);
+        holder.Set({key, {"s", "n", i, "c", 1, -1}});
+        holder.Update(key, {"", "", kAny, "city", kAny, -1});
+        if (i % 3 == 0) holder.Rename(key, "r" + key);
+        if (i % 5 == 0) holder.Del(i % 3 == 0 ? "r" + key : key);
+        holder.Exists(std::to_string((t + 1) % threads_count) + "_" + std::to_string(i));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  size_t expected_size = 0;
+  for (int t = 0; t < threads_count; ++t) {
+    for (int i = 0; i < count; ++i) {
+      const std::string key = std::to_string(t) + "_" + std::to_string(i);
+      const std::string stored_key = i % 3 == 0 ? "r" + key : key;
+      ASSERT_EQ(holder.Exists(stored_key), i % 5 != 0);
+      ASSERT_EQ(holder.Exists(i % 3 == 0 ? key : "r" + key), false);
+      if (i % 5 != 0) {
+        ASSERT_EQ(holder.Get(stored_key).GetCity(), "city");
+        ++expected_size;
+      }
+    }
+  }
+  ASSERT_EQ(holder.Keys().size(), expected_size);
+  ASSERT_EQ(holder.Find({"", "", kAny, "city", kAny, -1}).size(), expected_size);
+}
+
+TEST(Transactions, concurrent_lock_free_reads) {
+  s21::ConcurrentHashTable table;
+  const int count = 500;
+  for (int i = 0; i < count; ++i) table.Set({"key" + std::to_string(i), {"s", "n", 1, "0", 1, -1}});
+  std::atomic<bool> is_writing = true;
+  std::atomic<int> bad_reads = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&table, &is_writing, &bad_reads]() {
+      for (int i = 0; is_writing; i = (i + 1) % count) {
+        const std::string key = "key" + std::to_string(i);
+        table.Visit(key, [&bad_reads, &key](const s21::Storage::Element& element) {
+          if (element.GetKey() != key || element.GetName() != "n") ++bad_reads;
+        });
+        table.Exists(key);
+        if (table.Ttl(key) > 0) ++bad_reads;
+      }
+    });
+  }
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < count; ++i) {
+      const std::string key = "key" + std::to_string(i);
+      table.Update(key, {"", "", kAny, std::to_string(round), kAny, -1});
+      if (i % 7 == round % 7) {
+        table.Rename(key, "tmp" + key);
+        table.Rename("tmp" + key, key);
+      }
+      if (i % 11 == round % 11) {
+        table.Del(key);
+        table.Set({key, {"s", "n", 1, "0", 1, -1}});
+      }
+    }
+    if (round == 10) {
+      table.Init();
+      for (int i = 0; i < count; ++i) table.Set({"key" + std::to_string(i), {"s", "n", 1, "0", 1, -1}});
+    }
+  }
+  is_writing = false;
+  for (auto& reader : readers) reader.join();
+  ASSERT_EQ(bad_reads, 0);
+  ASSERT_EQ(table.Keys().size(), count);
+  ASSERT_EQ(s21::Epoch::Reclaim(), 0);
+}
+
+TEST(Transactions, hash_distribution_report) {
+  std::vector<std::string> files = {
+    "sources/example.data", "sources/test_5.data", "sources/test_110.data"
+  };
+  std::cout << "file                     keys   capacity  avg probe  max probe  "
+               "64-bit collisions  fingerprint collisions" << std::endl;
+  auto print_report = [](const std::string& name, const s21::HashTable::Statistics& statistics) {
+    std::cout << std::left << std::setw(25) << name << std::setw(7) << statistics.size
+              << std::setw(10) << statistics.capacity << std::setw(11) << statistics.average_probe
+              << std::setw(11) << statistics.max_probe << std::setw(19) << statistics.full_collisions
+              << statistics.fingerprint_collisions << std::endl;
+  };
+  for (auto& file : files) {
+    s21::HashTable hash_table;
+    hash_table.Upload(file);
+    auto statistics = hash_table.GetStatistics();
+    print_report(file, statistics);
+    EXPECT_EQ(statistics.full_collisions, 0);
+    EXPECT_LT(statistics.average_probe, 2.0);
+  }
+  s21::HashTable hash_table;
+  for (int i = 1; i <= 100000; ++i) hash_table.Set({"key" + std::to_string(i), {}});
+  auto statistics = hash_table.GetStatistics();
+  print_report("key1..key100000", statistics);
+  EXPECT_EQ(statistics.full_collisions, 0);
+  EXPECT_LT(statistics.average_probe, 2.0);
+  EXPECT_LT(statistics.max_probe, 64);
+}
+
+TEST(Transactions, visit_without_allocations) {
+  s21::SelfBalancingBinarySearchTree AVL;
+  s21::HashTable hash_table;
+  s21::BPlusTree b_treee;
+  s21::SwissTable swiss_table;
+  s21::ConcurrentHashTable concurrent_table;
+  std::vector<s21::Storage*> storages = {&AVL, &hash_table, &b_treee, &swiss_table, &concurrent_table};
+  /* fields too long for the inline string buffer, decoding them would
+     allocate */
+  const s21::Storage::Element long_fields("key_long_fields", {"surname_longer_than_sso", "name_longer_than_sso",
+                                          1990, "city_longer_than_sso", 5, -1});
+  s21::Holder holder(s21::Holder::StorageType::kHashTable);
+  holder.Set(long_fields);
+  for (auto storage : storages) {
+    for (size_t i = 0; i < elements.size(); ++i) storage->Set(elements[i]);
+    storage->Set(long_fields);
+  }
+  const std::string present = "key7";
+  const std::string absent = "unknown_key_with_a_long_name";
+  const std::string long_present = long_fields.GetKey();
+  for (auto storage : storages) {
+    std::string city;
+    city.reserve(64);
+    const size_t start = s21::AllocationCounter::Count();
+    ASSERT_TRUE(storage->Visit(present, [&city](const s21::Storage::Element& element) {
+      city = element.GetCity();
+    }));
+    ASSERT_FALSE(storage->Visit(absent, [&city](const s21::Storage::Element&) { city = ""; }));
+    ASSERT_TRUE(storage->Exists(present));
+    ASSERT_FALSE(storage->Exists(absent));
+    ASSERT_EQ(storage->Ttl(present), elements[6].GetLifeTime());
+    ASSERT_EQ(storage->Ttl(absent), 0);
+    ASSERT_TRUE(storage->Exists(long_present));
+    ASSERT_EQ(storage->Ttl(long_present), -1);
+    ASSERT_EQ(s21::AllocationCounter::Count(), start);
+    ASSERT_EQ(city, elements[6].GetCity());
+  }
+  /* the remover of the holder has no record with a life time to look at */
+  const size_t start = s21::AllocationCounter::Count();
+  ASSERT_TRUE(holder.Exists(long_present));
+  ASSERT_FALSE(holder.Exists(absent));
+  ASSERT_EQ(holder.Ttl(long_present), -1);
+  ASSERT_EQ(holder.Ttl(absent), 0);
+  ASSERT_EQ(s21::AllocationCounter::Count(), start);
+}
+
+TEST(Transactions, string_pool_interning) {
+  s21::HashTable hash_table;
+  hash_table.Set({"key1", {"Ivanov", "Ivan", 1990, "Novosibirsk", 10, -1}});
+  hash_table.Set({"key2", {"Petrov", "Ivan", 1991, "Novosibirsk", 20, -1}});
+  /* the pool lives as long as the process, a repeated run needs a name it
+     has not seen yet */
+  static int run = 0;
+  std::string new_name;
+  do {
+    new_name = "Pyotr_interned_" + std::to_string(run++);
+  } while (s21::StringPool::Find(new_name) != s21::StringPool::kNoCode);
+  const size_t pool_size = s21::StringPool::Size();
+  hash_table.Set({"key3", {"Ivanov", new_name, 1992, "Novosibirsk", 30, -1}});
+  ASSERT_EQ(s21::StringPool::Size(), pool_size + 1);
+  ASSERT_NE(s21::StringPool::Find(new_name), s21::StringPool::kNoCode);
+  ASSERT_EQ(&hash_table.Get("key1").GetCity(), &hash_table.Get("key2").GetCity());
+  ASSERT_EQ(hash_table.Get("key3").GetData(),
+            (s21::Storage::Element::Data{"Ivanov", new_name, 1992, "Novosibirsk", 30, -1}));
+  ASSERT_EQ(hash_table.Find({"", "", kAny, "Novosibirsk", kAny, -1}).size(), 3);
+  ASSERT_EQ(hash_table.Find({"Ivanov", "Ivan", kAny, "", kAny, -1}), std::vector<std::string>{"key1"});
+  ASSERT_TRUE(hash_table.Find({"", "", kAny, "Never_seen_city", kAny, -1}).empty());
+  ASSERT_EQ(s21::StringPool::Size(), pool_size + 1);
+  ASSERT_TRUE(hash_table.Update("key2", {"", "", kAny, "Berdsk", kAny, -1}));
+  ASSERT_EQ(hash_table.Find({"", "", kAny, "Berdsk", kAny, -1}), std::vector<std::string>{"key2"});
+  ASSERT_EQ(hash_table.Get("key2").GetSurname(), "Petrov");
+  ASSERT_EQ(s21::StringPool::Get(s21::StringPool::kEmptyCode), "");
+}
+
+TEST(Transactions, for_each_streams_records) {
+  s21::SelfBalancingBinarySearchTree AVL;
+  s21::HashTable hash_table;
+  s21::BPlusTree b_treee;
+  s21::SwissTable swiss_table;
+  s21::ConcurrentHashTable concurrent_table;
+  std::vector<s21::Storage*> storages = {&AVL, &hash_table, &b_treee, &swiss_table, &concurrent_table};
+  for (auto storage : storages) {
+    for (size_t i = 0; i < elements.size(); ++i) storage->Set(elements[i]);
+  }
+  for (auto storage : storages) {
+    std::vector<std::string> keys;
+    keys.reserve(elements.size());
+    size_t coins = 0;
+    const size_t start = s21::AllocationCounter::Count();
+    storage->ForEach([&keys, &coins](const s21::Storage::Element& element) {
+      keys.push_back(element.GetKey());
+      coins += element.GetCoins();
+    });
+    ASSERT_EQ(s21::AllocationCounter::Count(), start);
+    ASSERT_EQ(keys.size(), elements.size());
+    ASSERT_EQ(keys, storage->Keys());
+    auto all_elements = storage->AllElements();
+    for (size_t i = 0; i < keys.size(); ++i) ASSERT_EQ(all_elements[i].GetKey(), keys[i]);
+    ASSERT_GT(coins, 0);
+  }
+}
+
+TEST(Transactions, arena_size_classes) {
+  s21::Arena arena;
+  void* first = arena.Allocate(40);
+  void* second = arena.Allocate(48);
+  ASSERT_NE(first, second);
+  arena.Deallocate(first, 40);
+  ASSERT_EQ(arena.Allocate(33), first);
+  for (int i = 0; i < 1000; ++i) arena.Allocate(24);
+  ASSERT_EQ(arena.Blocks(), 1);
+  arena.Allocate(100000);
+  ASSERT_EQ(arena.Blocks(), 2);
+  arena.Release();
+  ASSERT_EQ(arena.Blocks(), 0);
+}
+
+/* Init must give back all the memory of the records, with and without keys
+   that do not fit the inline string buffer */
+TEST(Transactions, init_drops_records) {
+  s21::SelfBalancingBinarySearchTree AVL;
+  s21::HashTable hash_table;
+  s21::SwissTable swiss_table;
+  std::vector<s21::Storage*> storages = {&AVL, &hash_table, &swiss_table};
+  const s21::Storage::Element long_key("a_key_that_does_not_fit_the_string_itself", elements[0].GetData());
+  for (auto storage : storages) {
+    for (size_t i = 0; i < elements.size(); ++i) storage->Set(elements[i]);
+    storage->Set(long_key);
+    storage->Init();
+  }
+  for (bool with_long_key : {false, true}) {
+    for (auto storage : storages) {
+      const size_t bytes = s21::AllocationCounter::Bytes();
+      for (size_t i = 0; i < elements.size(); ++i) storage->Set(elements[i]);
+      if (with_long_key) storage->Set(long_key);
+      ASSERT_TRUE(storage->Rename("key1", "renamed_key_1"));
+      storage->Init();
+      ASSERT_EQ(s21::AllocationCounter::Bytes(), bytes);
+      ASSERT_TRUE(storage->Keys().empty());
+      storage->Set(elements[0]);
+      ASSERT_EQ(storage->Get("key1").GetData(), elements[0].GetData());
+      storage->Init();
+    }
+  }
+}
+
+/* a moved record keeps its key buffer: no allocation once the table has
+   room, while a copied one allocates its long key again */
+TEST(Transactions, set_moves_records) {
+  s21::HashTable hash_table;
+  s21::SwissTable swiss_table;
+  std::vector<s21::Storage*> storages = {&hash_table, &swiss_table};
+  const std::string long_key = "a_key_that_does_not_fit_the_string_itself";
+  for (auto storage : storages) {
+    storage->Set(elements[0]);
+    s21::Storage::Element element(long_key, elements[1].GetData());
+    size_t start = s21::AllocationCounter::Count();
+    storage->Set(std::move(element));
+    ASSERT_EQ(s21::AllocationCounter::Count(), start);
+    ASSERT_TRUE(element.GetKey().empty());
+    ASSERT_EQ(storage->Get(long_key).GetData(), elements[1].GetData());
+    const s21::Storage::Element copied(long_key + "_copy", elements[2].GetData());
+    start = s21::AllocationCounter::Count();
+    storage->Set(copied);
+    ASSERT_EQ(s21::AllocationCounter::Count(), start + 1);
+    ASSERT_EQ(storage->Get(long_key + "_copy").GetData(), elements[2].GetData());
+  }
+  /* made after the counted calls: the remover thread of a holder must not
+     run while the allocations are counted */
+  s21::Holder holder(s21::Holder::StorageType::kHashTable);
+  holder.Set(s21::Storage::Element(long_key, elements[1].GetData()));
+  ASSERT_EQ(holder.Get(long_key).GetData(), elements[1].GetData());
+}
+
+/* an indexed holder answers FIND like an engine scan after every kind of
+   modification, expired keys included */
+TEST(Transactions, secondary_index_find) {
+  using Data = s21::Storage::Element::Data;
+  s21::Holder holder(s21::Holder::StorageType::kAVL);
+  s21::BPlusTree scanned;
+  holder.AddIndex(s21::SecondaryIndex::kCity);
+  for (auto& element : elements) {
+    Data data = element.GetData();
+    data.life_time = -1;
+    holder.Set({element.GetKey(), data});
+    scanned.Set({element.GetKey(), data});
+  }
+  holder.AddIndex(s21::SecondaryIndex::kCoins);
+  ASSERT_TRUE(holder.IsIndexed(s21::SecondaryIndex::kCoins));
+  ASSERT_FALSE(holder.IsIndexed(s21::SecondaryIndex::kName));
+  const std::vector<Data> queries = {
+    {"", "", kAny, "City_1", kAny, -1}, {"", "", kAny, "City_3", 45, -1}, {"", "name_1", kAny, "", 15, -1},
+    {"", "", 1999, "", kAny, -1}, {"", "", kAny, "Unknown_city", kAny, -1}, {"", "", kAny, "City_2", kAny, -1},
+    {"", "", kAny, "City_1", kAny, -1}};
+  std::vector<s21::Storage::Element::Query> range_queries(4, s21::Storage::Element::EncodeQuery(queries[0]));
+  range_queries[0].coins = {10, 40};
+  range_queries[1].year_of_birth = {1995, 2000};
+  range_queries[1].coins = {20, 20000};
+  range_queries[2].city = s21::StringPool::kEmptyCode;
+  range_queries[2].coins = {0, 10};
+  range_queries[3].coins = {50, 40};
+  auto same_keys = [&holder, &scanned](const auto& query) {
+    auto found = holder.Find(query);
+    auto expected = scanned.Find(query);
+    ASSERT_TRUE(std::is_sorted(found.begin(), found.end()));
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(found, expected);
+  };
+  auto check = [&same_keys, &queries, &range_queries]() {
+    for (auto& query : queries) same_keys(query);
+    for (auto& query : range_queries) same_keys(query);
+  };
+  check();
+  scanned.Update("key1", {"", "", kAny, "City_2", 45, -1});
+  scanned.Del("key3");
+  scanned.Rename("key9", "key10");
+  ASSERT_TRUE(holder.Update("key1", {"", "", kAny, "City_2", 45, -1}));
+  ASSERT_TRUE(holder.Del("key3"));
+  ASSERT_TRUE(holder.Rename("key9", "key10"));
+  check();
+  holder.Set({"key11", {"surname_11", "name_1", 1999, "City_1", 15, static_cast<int>(std::time(nullptr)) + 1}});
+  ASSERT_EQ(holder.Find(queries[0]).size(), scanned.Find(queries[0]).size() + 1);
+  for (int i = 0; i < 300 && holder.Exists("key11"); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  check();
+  holder.DropIndex(s21::SecondaryIndex::kCity);
+  holder.DropIndex(s21::SecondaryIndex::kCoins);
+  check();
+}
+
+TEST(Transactions, find_ranges) {
+  s21::HashTable hash_table;
+  for (auto& element : elements) hash_table.Set(element);
+  using Range = s21::Storage::Element::Range;
+  auto find = [&hash_table](Range years, Range coins) {
+    auto query = s21::Storage::Element::EncodeQuery({"", "", kAny, "", kAny, -1});
+    query.year_of_birth = years;
+    query.coins = coins;
+    auto keys = hash_table.Find(query);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  };
+  ASSERT_EQ(find({1998, 2001}, {}), (std::vector<std::string>{"key1", "key2", "key3", "key7", "key9"}));
+  ASSERT_EQ(find({}, {0, 5}), (std::vector<std::string>{"key5", "key8", "key9"}));
+  ASSERT_EQ(find({2000, Range().max}, {30, 40}), std::vector<std::string>{"key3"});
+  ASSERT_EQ(find({}, {}).size(), elements.size());
+  ASSERT_TRUE(find({2001, 1999}, {}).empty());
+  ASSERT_EQ(hash_table.Find({"", "", 1999, "", kAny, -1}).size(), find({1999, 1999}, {}).size());
+}
+
+TEST(Transactions, roaring_bitmap) {
+  s21::RoaringBitmap evens, threes;
+  std::set<uint32_t> expected;
+  for (uint32_t i = 0; i < 200000; i += 2) evens.Add(i);
+  for (uint32_t i = 0; i < 200000; i += 3) threes.Add(i);
+  for (uint32_t i = 70000; i < 70010; ++i) evens.Add(i);
+  evens.Remove(4);
+  evens.Remove(5);
+  ASSERT_TRUE(evens.Contains(70001));
+  ASSERT_FALSE(evens.Contains(4));
+  ASSERT_EQ(evens.Cardinality(), 100004);
+  s21::RoaringBitmap both = evens;
+  both.And(threes);
+  both.ForEach([&expected](uint32_t value) { expected.insert(value); });
+  ASSERT_EQ(expected.size(), both.Cardinality());
+  for (uint32_t value : expected) ASSERT_TRUE(value % 6 == 0 || (value > 70000 && value < 70010));
+  ASSERT_TRUE(expected.count(6) && expected.count(70005) && !expected.count(4));
+  s21::RoaringBitmap any = threes;
+  any.Or(evens);
+  ASSERT_EQ(any.Cardinality(), evens.Cardinality() + threes.Cardinality() - both.Cardinality());
+  for (uint32_t i = 0; i < 200000; i += 3) any.Remove(i);
+  for (uint32_t i = 0; i < 200000; i += 2) any.Remove(i);
+  ASSERT_EQ(any.Cardinality(), 4);
+  ASSERT_LT(any.Bytes(), 1024);
+}
+
+TEST(Transactions, find_plans) {
+  s21::Holder holder(s21::Holder::StorageType::kHashTable);
+  s21::HashTable scanned;
+  for (int i = 0; i < 1000; ++i) {
+    s21::Storage::Element element("key" + std::to_string(i), {"surname", "name_" + std::to_string(i % 3),
+      1950 + i % 40, "City_" + std::to_string(i % 50), i % 100, -1});
+    scanned.Set(element);
+    holder.Set(std::move(element));
+  }
+  holder.AddIndex(s21::SecondaryIndex::kCity);
+  holder.AddIndex(s21::SecondaryIndex::kCoins);
+  holder.AddIndex(s21::SecondaryIndex::kYearOfBirth);
+  auto find = [&holder, &scanned](const s21::Storage::Element::Query& query, s21::SecondaryIndex::Plan* plan) {
+    auto found = holder.Find(query, plan);
+    auto expected = scanned.Find(query);
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(found, expected);
+    return found.size();
+  };
+  s21::SecondaryIndex::Plan plan;
+  auto query = s21::Storage::Element::EncodeQuery({"", "", kAny, "City_7", 7, -1});
+  ASSERT_EQ(find(query, &plan), 10);
+  ASSERT_FALSE(plan.is_scan);
+  ASSERT_EQ(plan.driver.field, s21::SecondaryIndex::kCoins);
+  ASSERT_EQ(plan.filters.size(), 1);
+  ASSERT_FALSE(plan.is_checked);
+  ASSERT_EQ(plan.rows_examined, 0);
+  query = s21::Storage::Element::EncodeQuery({"", "name_1", kAny, "City_7", kAny, -1});
+  find(query, &plan);
+  ASSERT_EQ(plan.driver.field, s21::SecondaryIndex::kCity);
+  ASSERT_TRUE(plan.is_checked);
+  ASSERT_EQ(plan.rows_examined, 20);
+  query.name = s21::StringPool::kEmptyCode;
+  query.year_of_birth = {1950, 1989};
+  find(query, &plan);
+  ASSERT_TRUE(plan.filters.empty());
+  ASSERT_EQ(plan.rows_examined, 20);
+  query = s21::Storage::Element::EncodeQuery({"", "name_1", kAny, "", kAny, -1});
+  query.coins = {0, 99};
+  ASSERT_EQ(find(query, &plan), 333);
+  ASSERT_TRUE(plan.is_scan);
+  ASSERT_EQ(plan.records, 1000);
+  ASSERT_EQ(plan.rows_examined, 1000);
+  query.name = s21::StringPool::kEmptyCode;
+  ASSERT_EQ(find(query, &plan), 1000);
+  ASSERT_FALSE(plan.is_scan);
+  query.coins = {50, 40};
+  ASSERT_EQ(find(query, &plan), 0);
+  ASSERT_EQ(plan.rows_examined, 0);
+  scanned.Del("key7");
+  ASSERT_TRUE(holder.Del("key7"));
+  ASSERT_EQ(find(s21::Storage::Element::EncodeQuery({"", "", kAny, "City_7", 7, -1}), &plan), 9);
+}
+
+TEST(Transactions, columnar_find) {
+  s21::Holder holder(s21::Holder::StorageType::kBTree);
+  s21::HashTable scanned;
+  for (int i = 0; i < 1000; ++i) {
+    s21::Storage::Element element("key" + std::to_string(i), {"surname_" + std::to_string(i % 7),
+      "name_" + std::to_string(i % 3), 1950 + i % 40, "City_" + std::to_string(i % 50), i % 100, -1});
+    scanned.Set(element);
+    holder.Set(std::move(element));
+  }
+  holder.SetColumnar(true);
+  ASSERT_TRUE(holder.IsColumnar());
+  auto query = s21::Storage::Element::EncodeQuery({"surname_3", "", kAny, "", kAny, -1});
+  std::vector<s21::Storage::Element::Query> queries(5, query);
+  queries[1].year_of_birth = {1960, 1970};
+  queries[2].surname = s21::StringPool::kEmptyCode;
+  queries[2].coins = {95, 1000};
+  queries[3] = s21::Storage::Element::EncodeQuery({"", "name_2", 1955, "City_5", kAny, -1});
+  queries[4].coins = {10, 5};
+  auto check = [&holder, &scanned, &queries]() {
+    for (auto& query : queries) {
+      s21::SecondaryIndex::Plan plan;
+      auto found = holder.Find(query, &plan);
+      auto expected = scanned.Find(query);
+      ASSERT_TRUE(std::is_sorted(found.begin(), found.end()));
+      std::sort(expected.begin(), expected.end());
+      ASSERT_EQ(found, expected);
+      ASSERT_TRUE(plan.is_columnar);
+    }
+  };
+  check();
+  scanned.Update("key3", {"", "", 1965, "", 99, -1});
+  scanned.Del("key10");
+  scanned.Del("key999");
+  scanned.Rename("key17", "key1000");
+  ASSERT_TRUE(holder.Update("key3", {"", "", 1965, "", 99, -1}));
+  ASSERT_TRUE(holder.Del("key10"));
+  ASSERT_TRUE(holder.Del("key999"));
+  ASSERT_TRUE(holder.Rename("key17", "key1000"));
+  check();
+  holder.Set({"key1001", {"surname_3", "name_1", 1999, "City_1", 15, static_cast<int>(std::time(nullptr)) + 1}});
+  ASSERT_EQ(holder.Find(queries[0]).size(), scanned.Find(queries[0]).size() + 1);
+  for (int i = 0; i < 300 && holder.Exists("key1001"); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  check();
+  holder.SetColumnar(false);
+  s21::SecondaryIndex::Plan plan;
+  holder.Find(queries[0], &plan);
+  ASSERT_FALSE(plan.is_columnar);
+  ASSERT_EQ(plan.rows_examined, 998);
+}
+
+TEST(Transactions, work_pool_runs_every_task) {
+  std::vector<std::atomic<int>> runs(1000);
+  std::vector<s21::WorkPool::Task> tasks;
+  for (size_t i = 0; i < runs.size(); ++i) tasks.push_back([&runs, i]() { ++runs[i]; });
+  s21::WorkPool::Instance().Run(&tasks);
+  s21::WorkPool::Instance().Run(&tasks);
+  for (auto& count : runs) ASSERT_EQ(count, 2);
+}
+
+TEST(Transactions, parallel_scans_keep_order) {
+  s21::HashTable hash_table;
+  s21::SwissTable swiss_table;
+  s21::SelfBalancingBinarySearchTree tree;
+  s21::BPlusTree b_plus_tree;
+  std::vector<s21::Storage*> storages = {&hash_table, &swiss_table, &tree, &b_plus_tree};
+  for (int i = 0; i < 30000; ++i) {
+    s21::Storage::Element element("key" + std::to_string(i * 7919 % 30000), {"surname", "name",
+      1950 + i % 40, "City_" + std::to_string(i % 50), i % 100, -1});
+    for (auto storage : storages) storage->Set(element);
+  }
+  auto query = s21::Storage::Element::EncodeQuery({"", "", kAny, "City_7", kAny, -1});
+  query.coins = {0, 50};
+  for (auto storage : storages) {
+    ASSERT_GT(storage->Split(16).size(), 1);
+    std::vector<std::string> keys, found;
+    storage->ForEach([&keys, &found, &query](const s21::Storage::Element& element) {
+      keys.push_back(element.GetKey());
+      if (s21::Storage::IsDataSiutable(query, element.GetRecord())) found.push_back(element.GetKey());
+    });
+    ASSERT_EQ(storage->Keys(), keys);
+    size_t examined = 0;
+    ASSERT_EQ(storage->Find(query, &examined), found);
+    ASSERT_EQ(examined, keys.size());
+    auto datas = storage->ShowAll();
+    ASSERT_EQ(datas.size(), keys.size());
+    ASSERT_EQ(datas[0], storage->Get(keys[0]).GetData());
+    /* the parts are written in order, each once */
+    const std::string file_name = "sources/test_parts_export.data";
+    ASSERT_EQ(storage->Export(file_name), static_cast<int>(keys.size()));
+    std::ifstream in(file_name);
+    std::vector<std::string> exported;
+    for (std::string line; std::getline(in, line);) exported.push_back(line.substr(0, line.find(' ')));
+    std::remove(file_name.c_str());
+    ASSERT_EQ(exported, keys);
+  }
+}
+
+TEST(Transactions, aggregates_follow_records) {
+  s21::Holder holder(s21::Holder::StorageType::kSwissTable);
+  for (int i = 0; i < 500; ++i) {
+    holder.Set({"key" + std::to_string(i), {"surname", "name", 1980 + i % 7, "City_" + std::to_string(i % 5),
+                i * 37 % 101, -1}});
+  }
+  auto check = [&holder]() {
+    std::map<std::string, s21::Aggregates::Summary> cities;
+    std::map<int32_t, s21::Aggregates::Summary> years;
+    holder.ForEach([&cities, &years](const s21::Storage::Element& element) {
+      for (auto summary : {&cities[element.GetCity()], &years[element.GetYearOfBirth()]}) {
+        summary->min = summary->count ? std::min(summary->min, element.GetCoins()) : element.GetCoins();
+        summary->max = summary->count ? std::max(summary->max, element.GetCoins()) : element.GetCoins();
+        ++summary->count;
+        summary->sum += element.GetCoins();
+      }
+    });
+    auto same = [](const s21::Aggregates::Summary& left, const s21::Aggregates::Summary& right) {
+      return left.count == right.count && left.sum == right.sum && left.min == right.min && left.max == right.max;
+    };
+    auto rows = holder.Aggregate(s21::Aggregates::kByCity);
+    ASSERT_EQ(rows.size(), cities.size());
+    for (auto& row : rows) ASSERT_TRUE(same(row.summary, cities[row.group]));
+    rows = holder.Aggregate(s21::Aggregates::kByYear);
+    ASSERT_EQ(rows.size(), years.size());
+    for (auto& row : rows) ASSERT_TRUE(same(row.summary, years[std::stoi(row.group)]));
+  };
+  check();
+  ASSERT_TRUE(holder.Update("key1", {"", "", 1950, "City_9", 1000, -1}));
+  ASSERT_TRUE(holder.Update("key2", {"", "", kAny, "", 0, -1}));
+  ASSERT_TRUE(holder.Del("key3"));
+  ASSERT_TRUE(holder.Rename("key4", "key4_renamed"));
+  for (int i = 100; i < 200; ++i) ASSERT_TRUE(holder.Del("key" + std::to_string(i)));
+  check();
+  s21::Aggregates::Summary summary;
+  ASSERT_TRUE(holder.Aggregate(s21::Aggregates::kByCity, "City_9", &summary));
+  ASSERT_EQ(summary.count, 1);
+  ASSERT_EQ(summary.Average(), 1000);
+  ASSERT_TRUE(holder.Aggregate(s21::Aggregates::kByYear, "1950", &summary));
+  ASSERT_FALSE(holder.Aggregate(s21::Aggregates::kByYear, "1900", &summary));
+  ASSERT_FALSE(holder.Aggregate(s21::Aggregates::kByYear, "1950abc", &summary));
+  ASSERT_FALSE(holder.Aggregate(s21::Aggregates::kByYear, "99999999999", &summary));
+  ASSERT_FALSE(holder.Aggregate(s21::Aggregates::kByYear, "-1950", &summary));
+  ASSERT_FALSE(holder.Aggregate(s21::Aggregates::kByCity, "Nowhere", &summary));
+  holder.Set({"key_ttl", {"surname", "name", 1950, "City_9", 5, static_cast<int>(std::time(nullptr)) + 1}});
+  ASSERT_TRUE(holder.Aggregate(s21::Aggregates::kByCity, "City_9", &summary));
+  ASSERT_EQ(summary.min, 5);
+  for (int i = 0; i < 300 && holder.Exists("key_ttl"); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  check();
+  holder.DropAggregate(s21::Aggregates::kByCity);
+  holder.DropAggregate(s21::Aggregates::kByYear);
+  for (int i = 200; i < 300; ++i) ASSERT_TRUE(holder.Del("key" + std::to_string(i)));
+  check();
+  holder.Init();
+  ASSERT_TRUE(holder.Aggregate(s21::Aggregates::kByCity).empty());
+}
+
+TEST(Transactions, scan_survives_changes) {
+  ASSERT_TRUE(s21::Storage::IsKeyMatch("key1*", "key1"));
+  ASSERT_TRUE(s21::Storage::IsKeyMatch("k*y?2*", "key12"));
+  ASSERT_FALSE(s21::Storage::IsKeyMatch("k*y?2", "key123"));
+  ASSERT_EQ(s21::Storage::LiteralPrefix("key1?*"), "key1");
+  for (auto type : {s21::Holder::StorageType::kHashTable, s21::Holder::StorageType::kSwissTable,
+                    s21::Holder::StorageType::kConcurrentHashTable, s21::Holder::StorageType::kAVL,
+                    s21::Holder::StorageType::kBTree}) {
+    s21::Holder holder(type);
+    for (int i = 0; i < 2000; ++i) holder.Set({"key" + std::to_string(i), {"surname", "name", 1990, "City", 1, -1}});
+    std::set<std::string> expected, found;
+    for (int i = 0; i < 2000; i += 2) expected.insert("key" + std::to_string(i));
+    std::string cursor = "0";
+    int step = 0;
+    do {
+      std::vector<std::string> keys;
+      cursor = holder.Scan(cursor, "*", 200, &keys);
+      found.insert(keys.begin(), keys.end());
+      /* the tables grow and lose records between the steps */
+      for (int i = 0; i < 100; ++i) {
+        holder.Set({"new" + std::to_string(step * 100 + i), {"surname", "name", 1990, "City", 1, -1}});
+      }
+      holder.Del("key" + std::to_string(step * 2 + 1));
+      ++step;
+    } while (cursor != "0");
+    ASSERT_GT(step, 10);
+    for (const auto& key : expected) ASSERT_EQ(found.count(key), 1);
+    std::set<std::string> present;
+    size_t prefixed = 0;
+    holder.ForEach([&present, &prefixed](const s21::Storage::Element& element) {
+      if (s21::Storage::IsKeyMatch("key1?4*", element.GetKey())) present.insert(element.GetKey());
+      if (s21::Storage::IsKeyMatch("key1*", element.GetKey())) ++prefixed;
+    });
+    std::vector<std::string> matched;
+    cursor = "0";
+    do {
+      cursor = holder.Scan(cursor, "key1?4*", 3, &matched);
+    } while (cursor != "0");
+    ASSERT_EQ(std::set<std::string>(matched.begin(), matched.end()), present);
+    if (type == s21::Holder::StorageType::kAVL || type == s21::Holder::StorageType::kBTree) {
+      ASSERT_TRUE(std::is_sorted(matched.begin(), matched.end()));
+      ASSERT_EQ(matched.size(), present.size());
+      /* the walk does not leave the prefix, one step covers it */
+      matched.clear();
+      ASSERT_EQ(holder.Scan("0", "key1?4*", prefixed + 1, &matched), "0");
+      ASSERT_EQ(matched.size(), present.size());
+    }
+  }
+  s21::Holder holder(s21::Holder::StorageType::kAVL);
+  std::vector<std::string> keys;
+  ASSERT_THROW(holder.Scan("12", "*", 10, &keys), std::invalid_argument);
+}
+
+TEST(Transactions, b_plus_tree_orders) {
+  s21::BasicBPlusTree<4> narrow;
+  s21::BasicBPlusTree<128> wide;
+  std::vector<s21::Storage*> trees = {&narrow, &wide};
+  std::map<std::string, int32_t> expected;
+  std::mt19937 random(21);
+  for (int i = 0; i < 20000; ++i) {
+    const std::string key = "key" + std::to_string(random() % 5000);
+    const int32_t coins = i;
+    switch (random() % 4) {
+      case 0:
+      case 1:
+        for (auto tree : trees) tree->Set({key, {"surname", "name", 1990, "City", coins, -1}});
+        expected.emplace(key, coins);
+        break;
+      case 2:
+        for (auto tree : trees) ASSERT_EQ(tree->Del(key), expected.count(key) == 1);
+        expected.erase(key);
+        break;
+      default: {
+        const std::string new_key = "key" + std::to_string(random() % 5000);
+        const bool is_renamed = expected.count(key) && (key == new_key || !expected.count(new_key));
+        for (auto tree : trees) ASSERT_EQ(tree->Rename(key, new_key), is_renamed);
+        if (is_renamed && key != new_key) {
+          expected[new_key] = expected[key];
+          expected.erase(key);
+        }
+      }
+    }
+  }
+  for (auto tree : trees) {
+    auto it = expected.begin();
+    tree->ForEach([&it, &expected](const s21::Storage::Element& element) {
+      ASSERT_NE(it, expected.end());
+      ASSERT_EQ(element.GetKey(), it->first);
+      ASSERT_EQ(element.GetCoins(), it->second);
+      ++it;
+    });
+    ASSERT_EQ(it, expected.end());
+  }
+  ASSERT_GT(narrow.Height(), wide.Height());
+  for (auto& record : expected) ASSERT_TRUE(wide.Del(record.first));
+  ASSERT_EQ(wide.Height(), 1);
+  s21::BPlusTree tree;
+  for (int i = 0; i < 100000; ++i) tree.Set({"key" + std::to_string(i), {"surname", "name", 1990, "City", 1, -1}});
+  ASSERT_LE(tree.Height(), 4);
+}
+
+TEST(Transactions, b_plus_tree_leaf_chain) {
+  s21::BasicBPlusTree<4> tree;
+  std::set<std::string> expected;
+  for (int i = 0; i < 20000; ++i) {
+    const std::string key = "key" + std::to_string(i * 7919 % 20000);
+    tree.Set({key, {"surname", "name", 1990, "City", i, -1}});
+    expected.insert(key);
+  }
+  /* merges and borrows relink the leaves */
+  for (int i = 0; i < 20000; i += 3) {
+    ASSERT_TRUE(tree.Del("key" + std::to_string(i)));
+    expected.erase("key" + std::to_string(i));
+  }
+  std::vector<std::string> forward, backward, parts;
+  tree.ForEach([&forward](const s21::Storage::Element& element) { forward.push_back(element.GetKey()); });
+  tree.ForEachBackward([&backward](const s21::Storage::Element& element) { backward.push_back(element.GetKey()); });
+  ASSERT_EQ(forward, std::vector<std::string>(expected.begin(), expected.end()));
+  ASSERT_EQ(backward, std::vector<std::string>(expected.rbegin(), expected.rend()));
+  auto split = tree.Split(8);
+  ASSERT_GT(split.size(), 1);
+  for (auto& part : split) {
+    part([&parts](const s21::Storage::Element& element) { parts.push_back(element.GetKey()); });
+  }
+  ASSERT_EQ(parts, forward);
+}
+
+TEST(Transactions, b_plus_tree_key_heads) {
+  s21::BPlusTree tree;
+  std::set<std::string> expected;
+  /* keys that differ only after the head, in it, and keys that are heads
+     of others */
+  for (int i = 0; i < 3000; ++i) {
+    for (const std::string& key : {"same_head_" + std::to_string(i), std::to_string(i), std::string(i % 12, 'k')}) {
+      tree.Set({key, {"surname", "name", 1990, "City", i, -1}});
+      expected.insert(key);
+    }
+  }
+  for (int i = 0; i < 3000; i += 2) {
+    ASSERT_TRUE(tree.Del("same_head_" + std::to_string(i)));
+    expected.erase("same_head_" + std::to_string(i));
+  }
+  ASSERT_TRUE(tree.Rename("same_head_1", "same_head_1a"));
+  expected.erase("same_head_1");
+  expected.insert("same_head_1a");
+  for (const auto& key : expected) ASSERT_TRUE(tree.Exists(key));
+  ASSERT_FALSE(tree.Exists("same_head_2"));
+  ASSERT_FALSE(tree.Exists("kkkkkkkkkkkkk"));
+  std::vector<std::string> keys;
+  tree.ForEach([&keys](const s21::Storage::Element& element) { keys.push_back(element.GetKey()); });
+  ASSERT_EQ(keys, std::vector<std::string>(expected.begin(), expected.end()));
+}
+
+TEST(Transactions, upload_builds_trees) {
+  const std::string file_name = "sources/test_load.data";
+  std::map<std::string, int32_t> expected;
+  {
+    std::ofstream out(file_name, std::ios::trunc);
+    /* keys out of order, the later lines of a key are left out */
+    for (int i = 0; i < 30000; ++i) {
+      const std::string key = "key" + std::to_string(i * 7919 % 20000);
+      out << key << " surname name 1990 City " << i << "\n";
+      expected.emplace(key, i);
+    }
+  }
+  s21::BasicBPlusTree<4> narrow;
+  s21::BPlusTree wide;
+  s21::SelfBalancingBinarySearchTree avl;
+  s21::HashTable hash;
+  std::vector<s21::Storage*> storages = {&narrow, &wide, &avl, &hash};
+  for (auto storage : storages) ASSERT_EQ(storage->Upload(file_name), 30000);
+  std::remove(file_name.c_str());
+  /* 5000 leaves of 4 under 7 levels */
+  ASSERT_EQ(narrow.Height(), 8);
+  for (int i = 0; i < 20000; i += 3) {
+    const std::string key = "key" + std::to_string(i);
+    for (auto storage : storages) ASSERT_TRUE(storage->Del(key));
+    expected.erase(key);
+    for (auto storage : storages) storage->Set({key + "a", {"surname", "name", 1990, "City", i, -1}});
+    expected.emplace(key + "a", i);
+  }
+  for (auto storage : storages) {
+    size_t count = 0;
+    storage->ForEach([&count](const s21::Storage::Element&) { ++count; });
+    ASSERT_EQ(count, expected.size());
+    for (const auto& record : expected) ASSERT_EQ(storage->Get(record.first).GetCoins(), record.second);
+  }
+  std::vector<std::string> keys;
+  narrow.ForEach([&keys](const s21::Storage::Element& element) { keys.push_back(element.GetKey()); });
+  ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  /* a bad line stops the upload, the lines before it stay */
+  {
+    std::ofstream out(file_name, std::ios::trunc);
+    out << "key2 surname name 1990 City 2\nkey1 surname name 1990 City 1\nkey3 surname name\n"
+        << "key4 surname name 1990 City 4\n";
+  }
+  for (auto storage : storages) {
+    ASSERT_THROW(storage->Upload(file_name), std::invalid_argument);
+    ASSERT_TRUE(storage->Exists("key1"));
+    ASSERT_TRUE(storage->Exists("key2"));
+    ASSERT_FALSE(storage->Exists("key4"));
+    ASSERT_EQ(storage->Keys().size(), 2);
+  }
+  std::remove(file_name.c_str());
+}
+
+/* the shadows are built while other threads change the records of an
+   engine that locks itself */
+TEST(Transactions, concurrent_shadows) {
+  s21::Holder holder(s21::Holder::StorageType::kConcurrentHashTable);
+  std::atomic<bool> is_writing = true;
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+    writers.emplace_back([&holder, &is_writing, t]() {
+      for (int round = 0; is_writing; ++round) {
+        for (int i = 0; i < 200; ++i) {
+          const std::string key = std::to_string(t) + "_" + std::to_string(i);
+          holder.Set({key, {"s", "n", 1990, "City_" + std::to_string(i % 5), i, -1}});
+          if ((i + round) % 3 == 0) holder.Del(key);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 50; ++i) {
+    holder.AddIndex(s21::SecondaryIndex::kCity);
+    holder.SetColumnar(true);
+    holder.Aggregate(s21::Aggregates::kByCity);
+    holder.DropIndex(s21::SecondaryIndex::kCity);
+    holder.SetColumnar(false);
+    holder.DropAggregate(s21::Aggregates::kByCity);
+  }
+  holder.AddIndex(s21::SecondaryIndex::kCity);
+  holder.SetColumnar(true);
+  is_writing = false;
+  for (auto& writer : writers) writer.join();
+  const s21::Storage::Element::Data query = {"", "", kAny, "City_1", kAny, -1};
+  auto indexed = holder.Find(query);
+  holder.DropIndex(s21::SecondaryIndex::kCity);
+  auto columnar = holder.Find(query);
+  holder.SetColumnar(false);
+  auto scanned = holder.Find(query);
+  std::sort(indexed.begin(), indexed.end());
+  std::sort(columnar.begin(), columnar.end());
+  std::sort(scanned.begin(), scanned.end());
+  ASSERT_EQ(indexed, scanned);
+  ASSERT_EQ(columnar, scanned);
+  s21::Aggregates::Summary summary;
+  holder.Aggregate(s21::Aggregates::kByCity, "City_1", &summary);
+  ASSERT_EQ(summary.count, scanned.size());
+}
+
+TEST(Transactions, work_pool_rethrows) {
+  std::vector<std::atomic<int>> runs(1000);
+  std::vector<s21::WorkPool::Task> tasks;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    tasks.push_back([&runs, i]() {
+      ++runs[i];
+      if (i % 100 == 7) throw std::runtime_error("task " + std::to_string(i));
+    });
+  }
+  ASSERT_THROW(s21::WorkPool::Instance().Run(&tasks), std::runtime_error);
+  for (auto& count : runs) ASSERT_EQ(count, 1);
+  std::vector<s21::WorkPool::Task> single = {[]() { throw std::logic_error("single"); }};
+  ASSERT_THROW(s21::WorkPool::Instance().Run(&single), std::logic_error);
+  tasks.resize(7);
+  s21::WorkPool::Instance().Run(&tasks);
+  ASSERT_EQ(runs[0], 2);
+}
+
+/* more readers at once than a block of slots holds */
+TEST(Transactions, epoch_many_readers) {
+  s21::ConcurrentHashTable table;
+  table.Set({"key", {"s", "n", 1, "c", 1, -1}});
+  const int threads_count = 300;
+  std::atomic<int> pinned = 0;
+  std::atomic<int> found = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < threads_count; ++t) {
+    readers.emplace_back([&table, &pinned, &found]() {
+      s21::Epoch::Guard guard;
+      ++pinned;
+      while (pinned < threads_count) std::this_thread::yield();
+      if (table.Exists("key")) ++found;
+      table.Update("key", {"", "", kAny, "city", kAny, -1});
+    });
+  }
+  for (auto& reader : readers) reader.join();
+  ASSERT_EQ(found, threads_count);
+  ASSERT_EQ(s21::Epoch::Reclaim(), 0);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -7,8 +7,16 @@
 #include <random>
 #include <chrono>
 #include <deque>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include "allocation_counter.h"
 #include "containers/self_balancing_binary_search_tree.h"
 #include "containers/hash_table.h"
+#include "containers/swiss_table.h"
 #include "containers/b_plus_tree.h"
 
 namespace s21 {
@@ -38,6 +46,18 @@ void Transactions::ReadCommandFromConsole(const std::string& command) {
       Print(kSuccess);
       Print(kStorageHash);
     }
+  } else if (command == "SW" || command == "sw") {
+    if (Initialize(Holder::StorageType::kSwissTable)) {
+      SetDefaultPrintSettings();
+      Print(kSuccess);
+      Print(kStorageSwiss);
+    }
+  } else if (command == "CHT" || command == "cht") {
+    if (Initialize(Holder::StorageType::kConcurrentHashTable)) {
+      SetDefaultPrintSettings();
+      Print(kSuccess);
+      Print(kStorageConcurrentHash);
+    }
   } else if (command == "AVL" || command == "avl") {
     if (Initialize(Holder::StorageType::kAVL)) {
       SetDefaultPrintSettings();
@@ -84,6 +104,20 @@ void Transactions::TableCommandExecutor(const std::string& command) {
     ExportToFile(command);
   } else if (std::regex_search(command, std::regex(regex_[kCompare]))) {
     MakeStorageCompare(command);
+  } else if (std::regex_search(command, std::regex(regex_[kIndex]))) {
+    ChangeIndex(command, true);
+  } else if (std::regex_search(command, std::regex(regex_[kDropIndex]))) {
+    ChangeIndex(command, false);
+  } else if (std::regex_search(command, std::regex(regex_[kExplain]))) {
+    FindElement(command, true);
+  } else if (std::regex_search(command, std::regex(regex_[kColumnar]))) {
+    ChangeColumnar(command);
+  } else if (std::regex_search(command, std::regex(regex_[kStats]))) {
+    ShowAggregates(command);
+  } else if (std::regex_search(command, std::regex(regex_[kDropStats]))) {
+    DropAggregates(command);
+  } else if (std::regex_search(command, std::regex(regex_[kScan]))) {
+    ScanKeys(command);
   } else {
     std::cout << "ERROR: invalid command" << std::endl;
   }
@@ -93,16 +127,15 @@ void Transactions::AddElementToStorage(const std::string& command) {
   auto tokens = Parser(command);
   if (!storage_->Exists(tokens[1])) {
     int life_time = kDefault_life_time;
-    if (IsDigital(tokens[4]) && IsDigital(tokens[6])) {
+    int32_t year_of_birth, coins;
+    if (ParseNumber(tokens[4], &year_of_birth) && ParseNumber(tokens[6], &coins)) {
       if (tokens.size() == 9 && IsDigital(tokens[8])) {
         int time = std::stoi(tokens[8]);
         life_time = time != 0 ? time + std::time(nullptr) : 0;
       }
       if (life_time != 0) {
-        Storage::Element element =
-          {{tokens[1]}, {tokens[2], tokens[3], tokens[4], tokens[5], tokens[6], life_time}};
-        storage_->Set(element);
         ResetLengthPrintSettings(tokens);
+        storage_->Set({std::move(tokens[1]), {tokens[2], tokens[3], year_of_birth, tokens[5], coins, life_time}});
         ++size_;
         std::cout << "OK" << std::endl;
       } else {
@@ -116,10 +149,11 @@ void Transactions::AddElementToStorage(const std::string& command) {
 
 void Transactions::UpdateElement(const std::string& command) {
   auto tokens = Parser(command);
-  if ((tokens[4] == "-" || IsDigital(tokens[4])) && (tokens[6] == "-" || IsDigital(tokens[6]))) {
+  int32_t year_of_birth, coins;
+  if (ParseNumberOrAny(tokens[4], &year_of_birth) && ParseNumberOrAny(tokens[6], &coins)) {
     bool result =
-      storage_->Update(tokens[1], {tokens[2], tokens[3], tokens[4], tokens[5], tokens[6],
-        kDefault_life_time});
+      storage_->Update(tokens[1], {ParseTextOrAny(tokens[2]), ParseTextOrAny(tokens[3]), year_of_birth,
+        ParseTextOrAny(tokens[5]), coins, kDefault_life_time});
     if (result) {
       std::cout << "OK" << std::endl;
       ResetLengthPrintSettings(tokens);
@@ -131,12 +165,10 @@ void Transactions::UpdateElement(const std::string& command) {
 
 void Transactions::GetElement(const std::string& command) {
   auto tokens = Parser(command);
-  Storage::Element element = storage_->Get(tokens[1]);
-  if (element.GetKey() == "") {
-    std::cout << "(null)" << std::endl;
-  } else {
+  bool is_found = storage_->Visit(tokens[1], [this](const Storage::Element& element) {
     PrintElement(element);
-  }
+  });
+  if (!is_found) std::cout << "(null)" << std::endl;
 }
 
 void Transactions::CheckExistsElement(const std::string& command) {
@@ -152,12 +184,18 @@ void  Transactions::DeleteElement(const std::string& command) {
   std::cout << result << std::endl;
 }
 
-void Transactions::FindElement(const std::string& command) {
+void Transactions::FindElement(const std::string& command, bool is_explained) {
   auto tokens = Parser(command);
-  if ((tokens[3] == "-" || IsDigital(tokens[3])) && (tokens[5] == "-" || IsDigital(tokens[5]))) {
-    std::vector<std::string> result
-      = storage_->Find({tokens[1], tokens[2], tokens[3], tokens[4], tokens[5], kDefault_life_time});
-    if (result.size() > 0) {
+  if (is_explained) tokens.erase(tokens.begin());
+  Storage::Element::Query query = Storage::Element::EncodeQuery({ParseTextOrAny(tokens[1]),
+    ParseTextOrAny(tokens[2]), Storage::Element::Data::kAnyNumber, ParseTextOrAny(tokens[4]),
+    Storage::Element::Data::kAnyNumber, kDefault_life_time});
+  if (ParseRangeOrAny(tokens[3], &query.year_of_birth) && ParseRangeOrAny(tokens[5], &query.coins)) {
+    SecondaryIndex::Plan plan;
+    std::vector<std::string> result = storage_->Find(query, &plan);
+    if (is_explained) {
+      PrintPlan(plan, result.size());
+    } else if (result.size() > 0) {
       size_t num = 1;
       for (auto &element : result) {
         std::cout << num++ << ") " << element << std::endl;
@@ -168,16 +206,46 @@ void Transactions::FindElement(const std::string& command) {
   }
 }
 
+void Transactions::PrintPlan(const SecondaryIndex::Plan& plan, size_t found) const {
+  if (plan.is_scan) {
+    std::cout << (plan.is_columnar ? "columnar scan" : "full scan") << std::endl;
+  } else {
+    std::cout << "index on " << SecondaryIndex::FieldName(plan.driver.field) << ": "
+              << plan.driver.rows << " keys" << std::endl;
+    for (const SecondaryIndex::Predicate& filter : plan.filters) {
+      std::cout << "intersect with index on " << SecondaryIndex::FieldName(filter.field) << ": "
+                << filter.rows << " keys" << std::endl;
+    }
+    if (plan.is_checked) std::cout << "check the records" << std::endl;
+  }
+  std::cout << "rows examined: " << plan.rows_examined << std::endl;
+  std::cout << "found: " << found << std::endl;
+}
+
 void Transactions::ShowAllKeys() {
-  auto elements = storage_->AllElements();
-  size_t size = elements.size();
-  if (size > 0) {
-    for (size_t i = 0; i < elements.size(); ++i) {
-      std::cout << (i + 1) << ") " << elements[i].GetKey() << std::endl;
+  size_t counter = 0;
+  storage_->ForEach([&counter](const Storage::Element& element) {
+    std::cout << ++counter << ") " << element.GetKey() << "\n";
+  });
+  if (counter == 0) std::cout << "No elements" << std::endl;
+  std::cout.flush();
+}
+
+void Transactions::ScanKeys(const std::string& command) {
+  auto tokens = Parser(command);
+  std::string pattern = "*";
+  size_t count = kScanCount;
+  for (size_t i = 2; i + 1 < tokens.size(); i += 2) {
+    if (tokens[i] == "MATCH" || tokens[i] == "match") {
+      pattern = tokens[i + 1];
+    } else {
+      count = std::stoul(tokens[i + 1]);
     }
-  } else {
-    std::cout << "No elements" << std::endl;
   }
+  std::vector<std::string> keys;
+  std::cout << storage_->Scan(tokens[1], pattern, count, &keys) << "\n";
+  for (size_t i = 0; i < keys.size(); ++i) std::cout << i + 1 << ") " << keys[i] << "\n";
+  std::cout.flush();
 }
 
 void Transactions::RenameKey(const std::string& command) {
@@ -186,6 +254,69 @@ void Transactions::RenameKey(const std::string& command) {
   std::cout << result << std::endl;
 }
 
+void Transactions::ChangeIndex(const std::string& command, bool is_indexed) {
+  auto tokens = Parser(command);
+  SecondaryIndex::Field field;
+  if (!SecondaryIndex::ParseField(tokens[1], &field)) {
+    std::cout << "ERROR: unknown field \"" << tokens[1] << "\"" << std::endl;
+  } else {
+    if (is_indexed) {
+      storage_->AddIndex(field);
+    } else {
+      storage_->DropIndex(field);
+    }
+    std::cout << "OK" << std::endl;
+  }
+}
+
+void Transactions::ChangeColumnar(const std::string& command) {
+  auto tokens = Parser(command);
+  storage_->SetColumnar(tokens[1] == "ON" || tokens[1] == "on");
+  std::cout << "OK" << std::endl;
+}
+
+void Transactions::ShowAggregates(const std::string& command) {
+  auto tokens = Parser(command);
+  Aggregates::Grouping grouping;
+  Aggregates::ParseGrouping(tokens[1], &grouping);
+  std::vector<Aggregates::Row> rows;
+  if (tokens.size() > 2) {
+    Aggregates::Summary summary;
+    if (storage_->Aggregate(grouping, tokens[2], &summary)) rows.push_back({tokens[2], summary});
+  } else {
+    rows = storage_->Aggregate(grouping);
+  }
+  if (rows.empty()) {
+    std::cout << "no matches found" << std::endl;
+    return;
+  }
+  const size_t length = grouping == Aggregates::kByCity ? lengths_.city : lengths_.year;
+  std::cout
+  << std::setw(length) << std::left << (grouping == Aggregates::kByCity ? "City" : "Year")
+  << std::setw(kStatsLength) << std::left << "|Count"
+  << std::setw(kStatsLength) << std::left << "|Sum"
+  << std::setw(kStatsLength) << std::left << "|Min"
+  << std::setw(kStatsLength) << std::left << "|Max"
+  << "|Average" << std::endl;
+  for (const auto& row : rows) {
+    std::cout
+    << std::setw(length) << std::left << row.group
+    << std::setw(kStatsLength) << std::left << row.summary.count
+    << std::setw(kStatsLength) << std::left << row.summary.sum
+    << std::setw(kStatsLength) << std::left << row.summary.min
+    << std::setw(kStatsLength) << std::left << row.summary.max
+    << row.summary.Average() << std::endl;
+  }
+}
+
+void Transactions::DropAggregates(const std::string& command) {
+  auto tokens = Parser(command);
+  Aggregates::Grouping grouping;
+  Aggregates::ParseGrouping(tokens[1], &grouping);
+  storage_->DropAggregate(grouping);
+  std::cout << "OK" << std::endl;
+}
+
 void Transactions::ShowTtl(const std::string& command) {
   auto tokens = Parser(command);
   int result = storage_->Ttl(tokens[1]);
@@ -199,17 +330,15 @@ void Transactions::ShowTtl(const std::string& command) {
   }
 }
 
+/* the head is printed with the first record, nothing is copied out */
 void Transactions::ShowAllElements() {
-  auto elements = storage_->AllElements();
-  if (elements.size() > 0) {
-    PrintTableHead();
-    for (size_t i = 0; i < elements.size(); ++i) {
-      std::cout << std::setw(lengths_.number) << std::left << (i + 1);
-      PrintElement(elements[i], true);
-    }
-  } else {
-    std::cout << "No elements" << std::endl;
-  }
+  size_t counter = 0;
+  storage_->ForEach([this, &counter](const Storage::Element& element) {
+    if (counter == 0) PrintTableHead();
+    std::cout << std::setw(lengths_.number) << std::left << ++counter;
+    PrintElement(element, true);
+  });
+  if (counter == 0) std::cout << "No elements" << std::endl;
 }
 
 void Transactions::ExportToFile(const std::string& command) {
@@ -258,6 +387,48 @@ bool Transactions::IsDigital(const std::string& line) {
   return true;
 }
 
+/* digits only and small enough for the 32-bit fields of a record */
+bool Transactions::ParseNumber(const std::string& line, int32_t* number) {
+  if (!IsDigital(line)) return false;
+  const size_t kMaxDigits = std::numeric_limits<int32_t>::digits10;
+  if (line.empty() || line.length() > kMaxDigits) {
+    std::cout << "ERROR: value \"" << line << "\" is out of range" << std::endl;
+    return false;
+  }
+  *number = std::stoi(line);
+  return true;
+}
+
+/* FIND takes a number, "-", or a range "from..to" where either end may be
+   left out */
+bool Transactions::ParseRangeOrAny(const std::string& line, Storage::Element::Range* range) {
+  *range = Storage::Element::Range();
+  const size_t dots = line.find("..");
+  if (dots == std::string::npos) {
+    int32_t number;
+    if (!ParseNumberOrAny(line, &number)) return false;
+    if (!Storage::Element::Data::IsAny(number)) range->min = range->max = number;
+    return true;
+  }
+  const std::string from = line.substr(0, dots);
+  const std::string to = line.substr(dots + 2);
+  return (from.empty() || ParseNumber(from, &range->min)) && (to.empty() || ParseNumber(to, &range->max));
+}
+
+/* "-" in UPDATE and FIND means any value */
+bool Transactions::ParseNumberOrAny(const std::string& line, int32_t* number) {
+  if (line == "-") {
+    *number = Storage::Element::Data::kAnyNumber;
+    return true;
+  }
+  return ParseNumber(line, number);
+}
+
+std::string Transactions::ParseTextOrAny(const std::string& line) {
+  if (line == "-") return std::string();
+  return line;
+}
+
 void Transactions::ResetLengthPrintSettings(const std::vector<std::string> &tokens) {
   if (tokens[1].length() > lengths_.surname) lengths_.surname = tokens[1].length();
   if (tokens[2].length() > lengths_.name) lengths_.name = tokens[2].length();
@@ -276,21 +447,20 @@ void Transactions::SetDefaultPrintSettings() {
 }
 
 void Transactions::PrintElement(const Storage::Element &element, bool is_table_print) {
-  auto data = element.GetData();
   if (is_table_print) {
     std::cout
-    << std::setw(lengths_.surname) << std::left << data.surname
-    << std::setw(lengths_.name) << std::left << data.name
-    << std::setw(lengths_.year) << std::left << data.year_of_birth
-    << std::setw(lengths_.city) << std::left << data.city
-    << std::setw(lengths_.coins) << std::left << data.coins << std::endl;
+    << std::setw(lengths_.surname) << std::left << element.GetSurname()
+    << std::setw(lengths_.name) << std::left << element.GetName()
+    << std::setw(lengths_.year) << std::left << element.GetYearOfBirth()
+    << std::setw(lengths_.city) << std::left << element.GetCity()
+    << std::setw(lengths_.coins) << std::left << element.GetCoins() << std::endl;
   } else {
     std::cout
-    << data.surname << " "
-    << data.name << " "
-    << data.year_of_birth << " "
-    << data.city << " "
-    << data.coins << std::endl;
+    << element.GetSurname() << " "
+    << element.GetName() << " "
+    << element.GetYearOfBirth() << " "
+    << element.GetCity() << " "
+    << element.GetCoins() << std::endl;
   }
 }
 
@@ -328,6 +498,8 @@ void Transactions::PrintMenu() {
   Print(kWelcome);
   Print(kSwitch);
   Print(kStorageHash);
+  Print(kStorageSwiss);
+  Print(kStorageConcurrentHash);
   Print(kStorageAVL);
   Print(kStorageBTree);
   Print(kMakeCompare);
@@ -335,9 +507,12 @@ void Transactions::PrintMenu() {
 
 inline void Transactions::Print(const Message &message) {
   std::cout << messages[message];
-  if (message == kStorageAVL || message == kStorageHash || message == kStorageBTree) {
+  if (message == kStorageAVL || message == kStorageHash || message == kStorageSwiss
+      || message == kStorageConcurrentHash || message == kStorageBTree) {
     if ((message == kStorageAVL && type_ == Holder::StorageType::kAVL)
     || (message == kStorageHash && type_ == Holder::StorageType::kHashTable)
+    || (message == kStorageSwiss && type_ == Holder::StorageType::kSwissTable)
+    || (message == kStorageConcurrentHash && type_ == Holder::StorageType::kConcurrentHashTable)
     || (message == kStorageBTree && type_ == Holder::StorageType::kBTree)) {
       std::cout << messages[kActiv];
     }
@@ -364,10 +539,8 @@ void Transactions::MakeStorageCompare(const std::string& command) {
 }
 
 int Transactions::GetRandomNumber(int min, int max) {
-  std::random_device rd;
-  std::mt19937 rng(rd());
   std::uniform_int_distribution<int> uni(min, max);
-  return uni(rng);
+  return uni(random_generator_);
 }
 
 std::vector<Storage::Element> Transactions::CreateElements(int count_of_elements,
@@ -378,11 +551,10 @@ std::vector<Storage::Element> Transactions::CreateElements(int count_of_elements
     const std::string key = prefix + std::to_string(count_of_elements);
     const std::string surname = std::to_string(GetRandomNumber(0, 999));
     const std::string name = std::to_string(GetRandomNumber(0, 50));
-    const std::string year = std::to_string(GetRandomNumber(1922, 2022));
+    const int32_t year = GetRandomNumber(1922, 2022);
     const std::string city = std::to_string(GetRandomNumber(0, 99));
-    const std::string coins = std::to_string(GetRandomNumber(0, 99));
-    Storage::Element element = {{key}, {surname, name, year, city, coins, kDefault_life_time}};
-    elements.push_back(element);
+    const int32_t coins = GetRandomNumber(0, 99);
+    elements.emplace_back(key, Storage::Element::Data{surname, name, year, city, coins, kDefault_life_time});
     --count_of_elements;
   }
   return elements;
@@ -394,21 +566,37 @@ void Transactions::StartTest(int counter, const std::vector<Storage::Element>& e
   AvlTest(counter, elements, samples);
   std::cout << "\nStart Hash table tree test: \n";
   HashTableTest(counter, elements, samples);
+  std::cout << "\nStart Swiss table test: \n";
+  SwissTableTest(counter, elements, samples);
+  std::cout << "\nStart threads test: \n";
+  ThreadsTest(Holder::StorageType::kHashTable, counter, elements);
+  ThreadsTest(Holder::StorageType::kConcurrentHashTable, counter, elements);
+  std::cout << "\nStart readers test: \n";
+  ReadersTest(Holder::StorageType::kHashTable, counter, elements);
+  ReadersTest(Holder::StorageType::kConcurrentHashTable, counter, elements);
+  std::cout << "\nStart memory test: \n";
+  MemoryTest(elements);
+  std::cout << "\nStart B+ tree order test: \n";
+  BPlusTreeOrderTest(counter, elements);
+  std::cout << "\nStart index test: \n";
+  IndexTest(counter, elements);
   double avl_average = time_results_.GetAvlAverage();
   double hash_average = time_results_.GetHashAverage();
+  double swiss_average = time_results_.GetSwissAverage();
   std::cout << "\nAverage time:\n";
   std::cout << std::setw(kStringLength) << std::left  << "AVL: " << avl_average << " ms.\n";
   std::cout << std::setw(kStringLength) << std::left  << "Hash Table: " << hash_average << " ms.\n";
+  std::cout << std::setw(kStringLength) << std::left  << "Swiss Table: " << swiss_average << " ms.\n";
 }
 
 void Transactions::AvlTest(int counter, const std::vector<Storage::Element>& elements,
                                 const std::vector<Storage::Element>& samples) {
   Holder avl_holder(Holder::StorageType::kAVL);
-  for (auto &element : elements) {
-    avl_holder.Set(element);
-  }
+  FillTest(&avl_holder, elements);
   time_results_.avl_add_element = AddTest(&avl_holder, counter, samples);
   time_results_.avl_get_element = GetTest(&avl_holder, counter, elements);
+  RenameTest(&avl_holder, counter, elements);
+  AllocationTest(&avl_holder, counter, elements);
   time_results_.avl_get_all_elements = GetAllElementsTest(&avl_holder, counter);
   time_results_.avl_find_key = FindTest(&avl_holder, counter, elements);
   time_results_.avl_remove_element = RemoveTest(&avl_holder, counter, elements);
@@ -417,31 +605,65 @@ void Transactions::AvlTest(int counter, const std::vector<Storage::Element>& ele
 void Transactions::HashTableTest(int counter, const std::vector<Storage::Element>& elements,
                                 const std::vector<Storage::Element>& samples) {
   Holder hash_holder(Holder::StorageType::kHashTable);
-  for (auto &element : elements) {
-    hash_holder.Set(element);
-  }
+  FillTest(&hash_holder, elements);
   time_results_.hash_add_element = AddTest(&hash_holder, counter, samples);
   time_results_.hash_get_element = GetTest(&hash_holder, counter, elements);
+  RenameTest(&hash_holder, counter, elements);
+  LookupTest(&hash_holder, counter, elements);
+  AllocationTest(&hash_holder, counter, elements);
   time_results_.hash_get_all_elements = GetAllElementsTest(&hash_holder, counter);
   time_results_.hash_find_key = FindTest(&hash_holder, counter, elements);
   time_results_.hash_remove_element = RemoveTest(&hash_holder, counter, elements);
 }
 
+void Transactions::SwissTableTest(int counter, const std::vector<Storage::Element>& elements,
+                                const std::vector<Storage::Element>& samples) {
+  Holder swiss_holder(Holder::StorageType::kSwissTable);
+  FillTest(&swiss_holder, elements);
+  time_results_.swiss_add_element = AddTest(&swiss_holder, counter, samples);
+  time_results_.swiss_get_element = GetTest(&swiss_holder, counter, elements);
+  RenameTest(&swiss_holder, counter, elements);
+  LookupTest(&swiss_holder, counter, elements);
+  AllocationTest(&swiss_holder, counter, elements);
+  time_results_.swiss_get_all_elements = GetAllElementsTest(&swiss_holder, counter);
+  time_results_.swiss_find_key = FindTest(&swiss_holder, counter, elements);
+  time_results_.swiss_remove_element = RemoveTest(&swiss_holder, counter, elements);
+}
+
+void Transactions::FillTest(Holder* storage, const std::vector<Storage::Element>& elements) {
+  std::vector<double> latencies;
+  latencies.reserve(elements.size());
+  for (auto &element : elements) {
+    auto start_time = std::chrono::steady_clock::now();
+    storage->Set(element);
+    auto end_time = std::chrono::steady_clock::now();
+    latencies.push_back(std::chrono::duration<double, std::micro>(end_time - start_time).count());
+  }
+  if (latencies.empty()) return;
+  const size_t percentile = latencies.size() * 99 / 100;
+  std::nth_element(latencies.begin(), latencies.begin() + percentile, latencies.end());
+  const double p99 = latencies[percentile];
+  const double worst = *std::max_element(latencies.begin() + percentile, latencies.end());
+  std::cout << std::setw(kStringLength) << std::left << "fill test complited ";
+  std::cout << "p99 " << p99 << " us, worst " << worst << " us per set" << std::endl;
+}
+
 double Transactions::AddTest(Holder* storage, int counter, const std::vector<Storage::Element>& samples) {
   double result = 0;
+  const int counter_of_operations = counter;
   auto start_time = std::chrono::steady_clock::now();
   for (int i = 0; i < counter; ++i) {
     storage->Set(samples[i]);
   }
   auto end_time = std::chrono::steady_clock::now();
   result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-  std::cout << std::setw(kStringLength) << std::left << "add test complited ";
-  std::cout<< result << " ms." << std::endl;
+  PrintTestResult("add test complited ", result, counter_of_operations);
   return result;
 }
 
 double Transactions::GetTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements) {
   double result = 0;
+  const int counter_of_operations = counter;
   size_t size = elements.size() - 1;
   auto start_time = std::chrono::high_resolution_clock::now();
   while (counter > 0) {
@@ -451,13 +673,318 @@ double Transactions::GetTest(Holder* storage, int counter, const std::vector<Sto
   }
   auto end_time = std::chrono::high_resolution_clock::now();
   result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-  std::cout << std::setw(kStringLength) << std::left << "get test complited ";
-  std::cout << result << " ms." << std::endl;
+  PrintTestResult("get test complited ", result, counter_of_operations);
   return result;
 }
 
+/* moves random keys to a new name and back, so the data set is the same
+   afterwards; every step is two renames */
+void Transactions::RenameTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements) {
+  const int counter_of_operations = counter * 2;
+  size_t size = elements.size() - 1;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  while (counter > 0) {
+    const std::string& key = elements[GetRandomNumber(0, size)].GetKey();
+    const std::string new_key = key + "~";
+    storage->Rename(key, new_key);
+    storage->Rename(new_key, key);
+    --counter;
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  double result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+  PrintTestResult("rename test complited ", result, counter_of_operations);
+}
+
+/* heap bytes per record of every storage, next to the same records kept
+   as a key and a Data with its own strings */
+void Transactions::MemoryTest(const std::vector<Storage::Element>& elements) {
+  if (!AllocationCounter::IsCounting()) {
+    std::cout << "allocations are counted only in the build of make compare" << std::endl;
+    return;
+  }
+  const double count = elements.size();
+  auto print = [count](const std::string& name, size_t bytes) {
+    std::cout << std::setw(kStringLength) << std::left << name;
+    std::cout << bytes / count << " bytes/record" << std::endl;
+  };
+  {
+    size_t start = AllocationCounter::Bytes();
+    std::vector<std::pair<std::string, Storage::Element::Data>> plain_records;
+    plain_records.reserve(elements.size());
+    for (auto& element : elements) plain_records.emplace_back(element.GetKey(), element.GetData());
+    print("plain records ", AllocationCounter::Bytes() - start);
+  }
+  const std::vector<std::pair<std::string, Holder::StorageType>> types = {
+    {"hash table ", Holder::StorageType::kHashTable},
+    {"swiss table ", Holder::StorageType::kSwissTable},
+    {"concurrent hash ", Holder::StorageType::kConcurrentHashTable},
+    {"AVL ", Holder::StorageType::kAVL},
+    {"B tree ", Holder::StorageType::kBTree}};
+  for (auto& type : types) {
+    Holder holder(type.second);
+    std::vector<Storage::Element> records(elements);
+    const size_t start = AllocationCounter::Bytes();
+    const size_t start_count = AllocationCounter::Count();
+    for (auto& record : records) holder.Set(std::move(record));
+    const size_t allocations = AllocationCounter::Count() - start_count;
+    print(type.first, AllocationCounter::Bytes() - start);
+    std::cout << std::setw(kStringLength) << std::left << "  set allocations ";
+    std::cout << allocations / count << " allocations/record" << std::endl;
+    auto start_time = std::chrono::steady_clock::now();
+    holder.Init();
+    std::chrono::duration<double, std::micro> drop_time = std::chrono::steady_clock::now() - start_time;
+    std::cout << std::setw(kStringLength) << std::left << "  drop all " << drop_time.count() << " us" << std::endl;
+  }
+}
+
+/* the same records in trees of every order the B+ tree is built for: a
+   wider node makes the tree lower but compares more keys on each level */
+void Transactions::BPlusTreeOrderTest(int counter, const std::vector<Storage::Element>& elements) {
+  const size_t size = elements.size() - 1;
+  std::vector<size_t> indexes;
+  for (int i = 0; i < counter; ++i) indexes.push_back(GetRandomNumber(0, size));
+  auto run = [this, counter, &elements, &indexes](const std::string& name, auto tree) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (auto& element : elements) tree->Set(element);
+    std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "set ", time.count(), elements.size());
+    start_time = std::chrono::steady_clock::now();
+    for (size_t index : indexes) tree->Exists(elements[index].GetKey());
+    time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "lookup ", time.count(), counter);
+    std::cout << std::setw(kStringLength) << std::left << "  height " << tree->Height() << std::endl;
+  };
+  run("order 4 ", std::make_unique<BasicBPlusTree<4>>());
+  run("order 8 ", std::make_unique<BasicBPlusTree<8>>());
+  run("order 16 ", std::make_unique<BasicBPlusTree<16>>());
+  run("order 32 ", std::make_unique<BasicBPlusTree<32>>());
+  run("order 64 ", std::make_unique<BasicBPlusTree<64>>());
+  run("order 128 ", std::make_unique<BasicBPlusTree<128>>());
+}
+
+/* the same writes, city lookups and coins ranges of three values on a hash
+   table without indexes and with all five fields indexed */
+void Transactions::IndexTest(int counter, const std::vector<Storage::Element>& elements) {
+  const size_t size = elements.size() - 1;
+  std::vector<size_t> indexes;
+  for (int i = 0; i < counter; ++i) indexes.push_back(GetRandomNumber(0, size));
+  for (const std::string name : {"not indexed ", "indexed ", "columnar "}) {
+    Holder holder(Holder::StorageType::kHashTable);
+    if (name == "indexed ") {
+      for (int field = 0; field < SecondaryIndex::kFieldsCount; ++field) {
+        holder.AddIndex(static_cast<SecondaryIndex::Field>(field));
+      }
+    }
+    holder.SetColumnar(name == "columnar ");
+    auto start_time = std::chrono::steady_clock::now();
+    for (auto& element : elements) holder.Set(element);
+    std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "set ", time.count(), elements.size());
+
+    start_time = std::chrono::steady_clock::now();
+    for (size_t index : indexes) {
+      holder.Update(elements[index].GetKey(), {"", "", Storage::Element::Data::kAnyNumber,
+                    elements[size - index].GetCity(), elements[size - index].GetCoins(), kDefault_life_time});
+    }
+    time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "update ", time.count(), counter);
+
+    start_time = std::chrono::steady_clock::now();
+    for (size_t index : indexes) {
+      holder.Find({"", "", Storage::Element::Data::kAnyNumber, elements[index].GetCity(),
+                   Storage::Element::Data::kAnyNumber, kDefault_life_time});
+    }
+    time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "find by city ", time.count(), counter);
+
+    auto query = Storage::Element::EncodeQuery({"", "", Storage::Element::Data::kAnyNumber, "",
+                                                Storage::Element::Data::kAnyNumber, kDefault_life_time});
+    start_time = std::chrono::steady_clock::now();
+    for (size_t index : indexes) {
+      query.coins = {elements[index].GetCoins(), elements[index].GetCoins() + 2};
+      holder.Find(query);
+    }
+    time = std::chrono::steady_clock::now() - start_time;
+    PrintTestResult(name + "find coins range ", time.count(), counter);
+  }
+  Holder holder(Holder::StorageType::kHashTable);
+  for (auto& element : elements) holder.Set(element);
+  const size_t start = AllocationCounter::Bytes();
+  for (int field = 0; field < SecondaryIndex::kFieldsCount; ++field) {
+    holder.AddIndex(static_cast<SecondaryIndex::Field>(field));
+  }
+  if (AllocationCounter::IsCounting()) {
+    std::cout << std::setw(kStringLength) << std::left << "index of all fields ";
+    std::cout << static_cast<double>(AllocationCounter::Bytes() - start) / elements.size() << " bytes/record" << std::endl;
+  }
+
+  /* coins by city summed from SHOWALL against the kept aggregates */
+  auto start_time = std::chrono::steady_clock::now();
+  for (int i = 0; i < counter; ++i) {
+    std::map<std::string, int64_t> sums;
+    for (auto& data : holder.ShowAll()) sums[data.city] += data.coins;
+  }
+  std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start_time;
+  PrintTestResult("sum by city from showall ", time.count(), counter);
+  holder.Aggregate(Aggregates::kByCity);
+  start_time = std::chrono::steady_clock::now();
+  for (int i = 0; i < counter; ++i) holder.Aggregate(Aggregates::kByCity);
+  time = std::chrono::steady_clock::now() - start_time;
+  PrintTestResult("stats by city ", time.count(), counter);
+}
+
+/* every thread runs counter commands on random keys, one in ten is an
+   UPDATE, the rest are GET; threads double up to the number of cores */
+void Transactions::ThreadsTest(Holder::StorageType type, int counter,
+                               const std::vector<Storage::Element>& elements) {
+  Holder holder(type);
+  for (auto& element : elements) holder.Set(element);
+  const std::string name = type == Holder::StorageType::kHashTable ? "hash table " : "concurrent hash ";
+  const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  const Storage::Element::Data data = {"", "", Storage::Element::Data::kAnyNumber, "", 0,
+                                        kDefault_life_time};
+  for (int threads_count = 1;; threads_count = std::min(threads_count * 2, max_threads)) {
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads_count; ++i) {
+      threads.emplace_back([&holder, &elements, &data, counter, seed = random_generator_()]() {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<size_t> uni(0, elements.size() - 1);
+        for (int j = 0; j < counter; ++j) {
+          const std::string& key = elements[uni(generator)].GetKey();
+          if (j % 10 == 0) {
+            holder.Update(key, data);
+          } else {
+            holder.Visit(key, [](const Storage::Element&) {});
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    auto end_time = std::chrono::steady_clock::now();
+    double result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    std::cout << std::setw(kStringLength) << std::left
+              << name + std::to_string(threads_count) + " threads ";
+    std::cout << (result > 0 ? threads_count * counter / result : 0) << " ops/ms" << std::endl;
+    if (threads_count == max_threads) break;
+  }
+}
+
+/* reader threads run GET, EXISTS and TTL in turn while one more thread
+   keeps updating random keys, only the reads are counted */
+void Transactions::ReadersTest(Holder::StorageType type, int counter,
+                               const std::vector<Storage::Element>& elements) {
+  Holder holder(type);
+  for (auto& element : elements) holder.Set(element);
+  const std::string name = type == Holder::StorageType::kHashTable ? "hash table " : "concurrent hash ";
+  const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  const Storage::Element::Data data = {"", "", Storage::Element::Data::kAnyNumber, "", 0,
+                                        kDefault_life_time};
+  for (int threads_count = 1;; threads_count = std::min(threads_count * 2, max_threads)) {
+    std::atomic<bool> is_reading = true;
+    std::thread writer([&holder, &elements, &data, &is_reading, seed = random_generator_()]() {
+      std::mt19937 generator(seed);
+      std::uniform_int_distribution<size_t> uni(0, elements.size() - 1);
+      while (is_reading) holder.Update(elements[uni(generator)].GetKey(), data);
+    });
+    std::vector<std::thread> readers;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads_count; ++i) {
+      readers.emplace_back([&holder, &elements, counter, seed = random_generator_()]() {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<size_t> uni(0, elements.size() - 1);
+        for (int j = 0; j < counter; ++j) {
+          const std::string& key = elements[uni(generator)].GetKey();
+          if (j % 3 == 0) {
+            holder.Visit(key, [](const Storage::Element&) {});
+          } else if (j % 3 == 1) {
+            holder.Exists(key);
+          } else {
+            holder.Ttl(key);
+          }
+        }
+      });
+    }
+    for (auto& reader : readers) reader.join();
+    auto end_time = std::chrono::steady_clock::now();
+    is_reading = false;
+    writer.join();
+    double result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    std::cout << std::setw(kStringLength) << std::left
+              << name + std::to_string(threads_count) + " readers ";
+    std::cout << (result > 0 ? threads_count * counter / result : 0) << " reads/ms" << std::endl;
+    if (threads_count == max_threads) break;
+  }
+}
+
+/* EXISTS on stored keys and on keys that were never stored: a hit ends on
+   the record, a miss has to run the probe sequence to its end */
+void Transactions::LookupTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements) {
+  const size_t size = elements.size() - 1;
+  std::vector<std::string> hits;
+  std::vector<std::string> misses;
+  for (int i = 0; i < counter; ++i) {
+    hits.push_back(elements[GetRandomNumber(0, size)].GetKey());
+    misses.push_back("miss" + std::to_string(GetRandomNumber(0, size)));
+  }
+  for (auto keys : {&hits, &misses}) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (const auto& key : *keys) storage->Exists(key);
+    auto end_time = std::chrono::steady_clock::now();
+    double result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    PrintTestResult(keys == &hits ? "hit lookup test complited " : "miss lookup test complited ",
+                    result, counter);
+  }
+}
+
+void Transactions::AllocationTest(Holder* storage, int counter,
+                                  const std::vector<Storage::Element>& elements) {
+  if (!AllocationCounter::IsCounting()) {
+    std::cout << "allocations are counted only in the build of make compare" << std::endl;
+    return;
+  }
+  const size_t size = elements.size() - 1;
+  std::vector<size_t> indexes;
+  for (int i = 0; i < counter; ++i) indexes.push_back(GetRandomNumber(0, size));
+  auto print = [counter](const std::string& name, size_t allocations) {
+    std::cout << std::setw(kStringLength) << std::left << name;
+    std::cout << static_cast<double>(allocations) / counter << " allocations/op" << std::endl;
+  };
+
+  size_t start = AllocationCounter::Count();
+  for (size_t index : indexes) storage->Get(elements[index].GetKey());
+  print("get allocations ", AllocationCounter::Count() - start);
+
+  start = AllocationCounter::Count();
+  for (size_t index : indexes) {
+    storage->Visit(elements[index].GetKey(), [](const Storage::Element&) {});
+  }
+  print("visit allocations ", AllocationCounter::Count() - start);
+
+  auto print_scan = [](const std::string& name, size_t allocations) {
+    std::cout << std::setw(kStringLength) << std::left << name;
+    std::cout << allocations << " allocations/scan" << std::endl;
+  };
+  start = AllocationCounter::Count();
+  storage->AllElements();
+  print_scan("get all allocations ", AllocationCounter::Count() - start);
+
+  start = AllocationCounter::Count();
+  storage->ForEach([](const Storage::Element&) {});
+  print_scan("for each allocations ", AllocationCounter::Count() - start);
+
+  start = AllocationCounter::Count();
+  for (size_t index : indexes) storage->Exists(elements[index].GetKey());
+  print("exists allocations ", AllocationCounter::Count() - start);
+
+  start = AllocationCounter::Count();
+  for (size_t index : indexes) storage->Ttl(elements[index].GetKey());
+  print("ttl allocations ", AllocationCounter::Count() - start);
+}
+
 double Transactions::GetAllElementsTest(Holder* storage, int counter) {
   double result = 0;
+  const int counter_of_operations = counter;
   auto start_time = std::chrono::high_resolution_clock::now();
   while (counter > 0) {
     storage->AllElements();
@@ -465,13 +992,13 @@ double Transactions::GetAllElementsTest(Holder* storage, int counter) {
   }
   auto end_time = std::chrono::high_resolution_clock::now();
   result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-  std::cout << std::setw(kStringLength) << std::left << "get all test complited ";
-  std::cout << result << " ms." << std::endl;
+  PrintTestResult("get all test complited ", result, counter_of_operations);
   return result;
 }
 
 double Transactions::FindTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements) {
   double result = 0;
+  const int counter_of_operations = counter;
   size_t size = elements.size() - 1;
   auto start_time = std::chrono::high_resolution_clock::now();
   while (counter > 0) {
@@ -481,14 +1008,14 @@ double Transactions::FindTest(Holder* storage, int counter, const std::vector<St
   }
   auto end_time = std::chrono::high_resolution_clock::now();
   result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-  std::cout << std::setw(kStringLength) << std::left << "find test complited ";
-  std::cout << result << " ms." << std::endl;
+  PrintTestResult("find test complited ", result, counter_of_operations);
   return result;
 }
 
 double Transactions::RemoveTest(Holder* storage, int counter,
                               const std::vector<Storage::Element>& elements) {
   double result = 0;
+  const int counter_of_operations = std::min<int>(counter, elements.size());
   std::deque<Storage::Element> deque;
   std::copy(elements.begin(), elements.end(), std::front_inserter(deque));
 
@@ -500,11 +1027,15 @@ double Transactions::RemoveTest(Holder* storage, int counter,
   }
   auto end_time = std::chrono::high_resolution_clock::now();
   result = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-  std::cout << std::setw(kStringLength) << std::left << "delete test complited ";
-  std::cout << result << " ms." << std::endl;
+  PrintTestResult("delete test complited ", result, counter_of_operations);
   return result;
 }
 
+void Transactions::PrintTestResult(const std::string& name, double result, int counter) {
+  std::cout << std::setw(kStringLength) << std::left << name;
+  std::cout << result << " ms. (" << (counter > 0 ? result * 1000 / counter : 0) << " us/op)" << std::endl;
+}
+
 double Transactions::TimeResults::GetAvlAverage() {
   const double total_numbers = 5.0;
   double sum =
@@ -512,6 +1043,13 @@ double Transactions::TimeResults::GetAvlAverage() {
   return sum / total_numbers;
 }
 
+double Transactions::TimeResults::GetSwissAverage() {
+  const double total_numbers = 5.0;
+  double sum =
+    swiss_get_element + swiss_add_element + swiss_remove_element + swiss_get_all_elements + swiss_find_key;
+  return sum / total_numbers;
+}
+
 double Transactions::TimeResults::GetHashAverage() {
   const double total_numbers = 5.0;
   double sum =
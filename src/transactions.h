@@ -4,6 +4,7 @@
 #include "storage.h"
 #include <vector>
 #include <string>
+#include <random>
 #include "holder.h"
 
 namespace s21 {
@@ -17,6 +18,8 @@ class Transactions {
   enum Message {
     kWelcome,
     kStorageHash,
+    kStorageSwiss,
+    kStorageConcurrentHash,
     kStorageAVL,
     kStorageBTree,
     kMakeCompare,
@@ -39,6 +42,13 @@ class Transactions {
     kUpload,
     kExport,
     kCompare,
+    kIndex,
+    kDropIndex,
+    kExplain,
+    kColumnar,
+    kStats,
+    kDropStats,
+    kScan,
     kKeys,
     kShowall
   };
@@ -60,18 +70,30 @@ class Transactions {
     double hash_get_all_elements = 0;
     double hash_find_key = 0;
 
+    double swiss_get_element = 0;
+    double swiss_add_element = 0;
+    double swiss_remove_element = 0;
+    double swiss_get_all_elements = 0;
+    double swiss_find_key = 0;
+
     double avl_get_element = 0;
     double avl_add_element = 0;
     double avl_remove_element = 0;
     double avl_get_all_elements = 0;
     double avl_find_key = 0;
     double GetHashAverage();
+    double GetSwissAverage();
     double GetAvlAverage();
   } time_results_;
 
   static const int kDefault_life_time = -1;
   static const int kStringLength = 30;
+  /* width of a column of STATS */
+  static const int kStatsLength = 12;
+  /* records a step of SCAN looks at without COUNT */
+  static const size_t kScanCount = 10;
   size_t size_ = 0;
+  std::mt19937 random_generator_{std::random_device{}()};
 
   Holder *storage_ = nullptr;
   Holder::StorageType type_ = Holder::StorageType::kEmpty;
@@ -82,17 +104,28 @@ class Transactions {
   std::vector<std::string> Parser(const std::string& command);
   std::string RemoveSpaces(const std::string& command);
   bool IsDigital(const std::string& line);
+  bool ParseNumber(const std::string& line, int32_t* number);
+  bool ParseNumberOrAny(const std::string& line, int32_t* number);
+  bool ParseRangeOrAny(const std::string& line, Storage::Element::Range* range);
+  static std::string ParseTextOrAny(const std::string& line);
 
   void AddElementToStorage(const std::string& command);
   void UpdateElement(const std::string& command);
-  void FindElement(const std::string& command);
+  /* EXPLAIN FIND shows the plan and how many records it read */
+  void FindElement(const std::string& command, bool is_explained = false);
+  void PrintPlan(const SecondaryIndex::Plan& plan, size_t found) const;
   void GetElement(const std::string& command);
   void CheckExistsElement(const std::string& command);
   void DeleteElement(const std::string& command);
   void ShowAllKeys();
+  void ScanKeys(const std::string& command);
   void RenameKey(const std::string& command);
   void ShowTtl(const std::string& command);
   void ShowAllElements();
+  void ChangeIndex(const std::string& command, bool is_indexed);
+  void ChangeColumnar(const std::string& command);
+  void ShowAggregates(const std::string& command);
+  void DropAggregates(const std::string& command);
 
   void MakeStorageCompare(const std::string& command);
   std::vector<Storage::Element> CreateElements(int count_of_elements, const std::string& prefix);
@@ -101,12 +134,24 @@ class Transactions {
               const std::vector<Storage::Element>& samples);
   void HashTableTest(int counter, const std::vector<Storage::Element>& elements,
                     const std::vector<Storage::Element>& samples);
+  void SwissTableTest(int counter, const std::vector<Storage::Element>& elements,
+                    const std::vector<Storage::Element>& samples);
+  void ThreadsTest(Holder::StorageType type, int counter, const std::vector<Storage::Element>& elements);
+  void ReadersTest(Holder::StorageType type, int counter, const std::vector<Storage::Element>& elements);
 
+  void FillTest(Holder* storage, const std::vector<Storage::Element>& elements);
   double AddTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
   double GetTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
+  void LookupTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
+  void RenameTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
+  void MemoryTest(const std::vector<Storage::Element>& elements);
+  void BPlusTreeOrderTest(int counter, const std::vector<Storage::Element>& elements);
+  void IndexTest(int counter, const std::vector<Storage::Element>& elements);
   double FindTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
   double RemoveTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
   double GetAllElementsTest(Holder* storage, int counter);
+  void AllocationTest(Holder* storage, int counter, const std::vector<Storage::Element>& elements);
+  void PrintTestResult(const std::string& name, double result, int counter);
 
 
   int GetRandomNumber(int min, int max);
@@ -126,6 +171,8 @@ class Transactions {
     "(EXIT)                     Enter to exit the program\n"\
     "(HELP)                     Get help",
     "(HT)                       Hash table",
+    "(SW)                       Swiss table",
+    "(CHT)                      Concurrent hash table",
     "(AVL)                      Self balancing binary search tree",
     "(BT)                       B tree",
     "(COMPARE N1 N2)            make storage compare. N1 - number of elements, N2 - number of repeats",
@@ -135,16 +182,29 @@ class Transactions {
     "(UPDATE S1 S2 S3 N1 S4 N2) update elements data. S1 - key, S2 - surname, "\
       "S3 - name, N1 - year, S4 - city, N2 - coins \n"\
     "(FIND S1 S2 N1 S3 N2)      find element. S1 - surname, S2 - name, N1 - year, "\
-      "S3 - city, N2 - coins, or '-'. \n"\
+      "S3 - city, N2 - coins, or '-'. N1 and N2 may be ranges: 1990..2000, 1990.. or ..2000\n"\
     "(RENAME S1 S2)             rename key. S1 - old keys name, S2 - new keys name.\n"\
     "(GET S1)                   show element. S1 - key\n"\
     "(EXISTS S1)                check element. S1 - key\n"\
     "(DEL S1)                   remove element. S1 - key\n"\
     "(KEYS)                     show all keys.\n"\
+    "(SCAN S1 MATCH S2 COUNT N1)\n"\
+    "                           show keys step by step. S1 - cursor, 0 at first, the next one is shown\n"\
+    "                           first, 0 at the end. S2 - pattern, * and ? are wildcards, N1 - records\n"\
+    "                           to look at. MATCH and COUNT may be left out.\n"\
     "(SHOWALL)                  show all elements table.\n"\
     "(UPLOAD S1)                load data from file. S1 - file path.\n"\
     "(EXPORT S1)                Save data to file. S1 - file path.\n"\
-    "(TTL S1)                   show element current life time. S1 - key.",
+    "(TTL S1)                   show element current life time. S1 - key.\n"\
+    "(INDEX S1)                 index a field for FIND. S1 - surname, name, year, city or coins.\n"\
+    "(DROPINDEX S1)             drop the index of a field. S1 - field name.\n"\
+    "(EXPLAIN FIND ...)         show how FIND reads the records and how many it reads.\n"\
+    "(COLUMNAR S1)              keep records by columns for FIND without index. S1 - ON or OFF.\n"\
+    "(STATS S1 S2)              count, sum, min, max and average of coins by group. S1 - city or year,\n"\
+    "                           S2 - the group, all groups when left out. The groups are kept from\n"\
+    "                           then on: with the concurrent storage every command waits for the\n"\
+    "                           others until DROPSTATS.\n"\
+    "(DROPSTATS S1)             stop keeping the groups of STATS. S1 - city or year.",
     " [ACTIV] ",
     "       Enter type name to switch storage type",
     "Successfully switched",
@@ -160,10 +220,19 @@ class Transactions {
     "^((UPDATE|update){1}[ ]+[^ ]+[ ]+[^ ]+[ ]+[^ ]+[ ]+[0-9-]{1,14}[ ]+[^ ]+[ ]+[0-9-]{1,14}[ ]{0,})$",
     "^(RENAME|rename)[ ]+[^ ]+[ ]+[^ ]+[ ]{0,}$",
     "^(TTL|ttl)[ ]+[^ ]{1,}[ ]{0,}$",
-    "^((FIND|find){1}[ ]+[^ ]+[ ]+[^ ]+[ ]+[0-9-]{1,14}[ ]+[^ ]+[ ]+[0-9-]{1,14}[ ]{0,})$",
+    "^((FIND|find){1}[ ]+[^ ]+[ ]+[^ ]+[ ]+(-|[0-9]{1,14}|[0-9]{0,14}\\.\\.[0-9]{0,14})[ ]+[^ ]+[ ]+"\
+    "(-|[0-9]{1,14}|[0-9]{0,14}\\.\\.[0-9]{0,14})[ ]{0,})$",
     "^(UPLOAD|upload)[ ]+[^ ]{1,}[ ]{0,}$",
     "^(EXPORT|export)[ ]+[^ ]{1,}[ ]{0,}$",
-    "^(COMPARE|compare)[ ]+[0-9]{1,10}+[ ]+[0-9]{1,10}+[ ]{0,}$"
+    "^(COMPARE|compare)[ ]+[0-9]{1,10}+[ ]+[0-9]{1,10}+[ ]{0,}$",
+    "^(INDEX|index)[ ]+[a-z]+[ ]{0,}$",
+    "^(DROPINDEX|dropindex)[ ]+[a-z]+[ ]{0,}$",
+    "^((EXPLAIN|explain)[ ]+(FIND|find){1}[ ]+[^ ]+[ ]+[^ ]+[ ]+(-|[0-9]{1,14}|[0-9]{0,14}\\.\\.[0-9]{0,14})"\
+    "[ ]+[^ ]+[ ]+(-|[0-9]{1,14}|[0-9]{0,14}\\.\\.[0-9]{0,14})[ ]{0,})$",
+    "^(COLUMNAR|columnar)[ ]+(ON|on|OFF|off)[ ]{0,}$",
+    "^(STATS|stats)[ ]+(city|year)([ ]+[^ ]+)?[ ]{0,}$",
+    "^(DROPSTATS|dropstats)[ ]+(city|year)[ ]{0,}$",
+    "^(SCAN|scan)[ ]+[^ ]+([ ]+(MATCH|match)[ ]+[^ ]+)?([ ]+(COUNT|count)[ ]+[0-9]{1,9})?[ ]{0,}$"
   };
 };
 
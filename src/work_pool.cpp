@@ -0,0 +1,110 @@
+#include "work_pool.h"
+#include <algorithm>
+
+namespace s21 {
+
+WorkPool& WorkPool::Instance() {
+  static WorkPool pool;
+  return pool;
+}
+
+WorkPool::WorkPool() {
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+  for (size_t i = 0; i + 1 < threads; ++i) workers_.emplace_back(&WorkPool::Work, this, i);
+}
+
+WorkPool::~WorkPool() {
+  {
+    std::lock_guard lock(mutex_);
+    is_stopped_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+size_t WorkPool::Threads() const {
+  return queues_.size();
+}
+
+void WorkPool::Run(std::vector<Task>* tasks) {
+  if (tasks->empty()) return;
+  std::exception_ptr error;
+  if (workers_.empty() || tasks->size() == 1) {
+    for (auto& task : *tasks) Call(task, &error);
+    if (error) std::rethrow_exception(error);
+    return;
+  }
+  std::lock_guard run_lock(run_mutex_);
+  const size_t count = tasks->size();
+  for (size_t i = 0; i < count; ++i) queues_[i * queues_.size() / count]->tasks.push_back(i);
+  {
+    std::lock_guard lock(mutex_);
+    tasks_ = tasks;
+    error_ = &error;
+    busy_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+  Drain(queues_.size() - 1);
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+  tasks_ = nullptr;
+  error_ = nullptr;
+  lock.unlock();
+  if (error) std::rethrow_exception(error);
+}
+
+void WorkPool::Work(size_t worker) {
+  size_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this, generation] { return is_stopped_ || generation_ != generation; });
+      if (is_stopped_) return;
+      generation = generation_;
+    }
+    Drain(worker);
+    std::lock_guard lock(mutex_);
+    if (--busy_ == 0) done_.notify_one();
+  }
+}
+
+/* tasks do not add tasks, so when every queue is found empty the run has
+   nothing left to take */
+void WorkPool::Drain(size_t queue) {
+  size_t task;
+  while (true) {
+    bool is_found = Pop(queue, &task, true);
+    for (size_t i = 1; !is_found && i < queues_.size(); ++i) {
+      is_found = Pop((queue + i) % queues_.size(), &task, false);
+    }
+    if (!is_found) return;
+    Call((*tasks_)[task], error_);
+  }
+}
+
+void WorkPool::Call(const Task& task, std::exception_ptr* error) {
+  try {
+    task();
+  } catch (...) {
+    std::lock_guard lock(mutex_);
+    if (!*error) *error = std::current_exception();
+  }
+}
+
+bool WorkPool::Pop(size_t queue, size_t* task, bool is_own) {
+  std::lock_guard lock(queues_[queue]->mutex);
+  auto& tasks = queues_[queue]->tasks;
+  if (tasks.empty()) return false;
+  if (is_own) {
+    *task = tasks.front();
+    tasks.pop_front();
+  } else {
+    *task = tasks.back();
+    tasks.pop_back();
+  }
+  return true;
+}
+
+}  // namespace s21
@@ -0,0 +1,65 @@
+#ifndef SRC_WORK_POOL_H_
+#define SRC_WORK_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+/* Threads shared by the parallel scans, one less than the cores: the
+   thread that runs the tasks works too. The tasks of a run are dealt in
+   neighbouring runs to the workers, a worker takes its own from the front
+   and, when they are over, steals from the back of the others. One run at
+   a time, a task must not start another run. */
+class WorkPool {
+ public:
+  using Task = std::function<void()>;
+
+  static WorkPool& Instance();
+  WorkPool(const WorkPool&) = delete;
+  WorkPool& operator=(const WorkPool&) = delete;
+
+  /* returns when every task is done; a task that throws does not stop the
+     others, the first exception is thrown again once they are over */
+  void Run(std::vector<Task>* tasks);
+  /* the workers and the calling thread */
+  size_t Threads() const;
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+  };
+
+  std::vector<std::thread> workers_;
+  /* one more than the workers, the last is of the calling thread */
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<Task>* tasks_ = nullptr;
+  /* the first exception of the run */
+  std::exception_ptr* error_ = nullptr;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  size_t generation_ = 0;
+  size_t busy_ = 0;
+  bool is_stopped_ = false;
+
+  WorkPool();
+  ~WorkPool();
+  void Work(size_t worker);
+  void Drain(size_t queue);
+  void Call(const Task& task, std::exception_ptr* error);
+  bool Pop(size_t queue, size_t* task, bool is_own);
+};
+
+}  // namespace s21
+
+#endif  // SRC_WORK_POOL_H_